@@ -55,6 +55,10 @@
  * Its usage is
  *   INS_GPS [option(s)] <log.dat>,
  * where <log.dat> is a mandatory parameter pointing to a log file stored in a logger.
+ * Multiple log files can be given as
+ *   INS_GPS [option(s)] --log_out=<out1.csv> <log1.dat> --log_out=<out2.csv> <log2.dat> ...,
+ * where each log is processed independently in parallel, and its results are written to
+ * the output specified with --log_out preceding it.
  * There are some reserved values for <log.dat>; If <log.dat> equals to - (hyphen),
  * the program will try to read log data from the standard input.
  * Or, when <log.dat> is COMx for Windows or /dev/ttyACMx for *NIX,
@@ -73,6 +77,10 @@
  *      specifies end GPS time for INS/GPS post-process.
  *   --end_gpst=(GPS week):(GPS time in week [sec])
  *      specifies end GPS week and time for INS/GPS post-process.
+ *   --use_index=<on|off>
+ *      specifies whether the sidecar index <log.dat>.idx generated by log_index is utilized,
+ *      or not. With the index, processing starts a little before the above start time
+ *      instead of the beginning of the log. The default is on.
  *
  *   --dump_update=<on|off>
  *      specifies whether the program outputs results when inertial information is obtained
@@ -105,6 +113,18 @@
  *   --use_udkf=<off|on>
  *      specifies whether the UD factorized Kalamn filter (UDKF), or the standard Kalman
  *      filter is utilized. The default is off (standard KF).
+ *   --use_egm=<off|on>
+ *      specifies whether the Earth gravity model (EGM2008, up to degree 70), or the simplified
+ *      WGS84 gravity model is utilized. The default is off (WGS84).
+ *   --egm_grid=(file name)
+ *      loads a gravity grid generated by gravity_grid, and turns on --use_egm.
+ *      Gravity inside of the grid is interpolated instead of evaluating the model.
+ *   --predict_interval=(interval [sec])
+ *      specifies the interval of covariance propagation of the Kalman filter.
+ *      While INS is updated at every inertial sensor sample, the propagation is
+ *      accumulated until the interval elapses, or until the next measurement update.
+ *      The default is 0, which means the propagation at every sample.
+ *      It cannot be combined with --back_propagate or --realtime.
  *
  *   --direct_sylphide=<off|on>
  *   --in_sylphide=<off|on>
@@ -112,6 +132,14 @@
  *      The default is off. Please use this option with "on" value when the program directly read
  *      data from the NinjaScan logger in USB CDC Mode.
  *
+ *   --log_out=(file name)
+ *   --log_out_debug=(file name)
+ *      specify output (and debug output) of the log file following them.
+ *      --log_out is mandatory for each log when multiple log files are given.
+ *   --threads=(number)
+ *      specifies the number of worker threads to process multiple log files.
+ *      The default is 0, which means the number of available CPU cores.
+ *
  *   --gps_init_acc_2d=(sigma [m])
  *   --gps_init_acc_v=(sigma [m])
  *   --gps_cont_acc_2d=(sigma [m])
@@ -152,6 +180,12 @@
 #include <deque>
 #include <algorithm>
 
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1700))
+#define INS_GPS_USE_THREAD 1
+#include <thread>
+#include <atomic>
+#endif
+
 #define IS_LITTLE_ENDIAN 1
 #include "SylphideStream.h"
 #include "SylphideProcessor.h"
@@ -163,18 +197,10 @@ typedef double float_sylph_t;
 #include "param/quaternion.h"
 #include "param/complex.h"
 
-template <>
-struct Vector3Data_TypeMapper<float_sylph_t> {
-  typedef Vector3Data_NoFlyWeight<float_sylph_t> res_t;
-};
-template <>
-struct QuaternionData_TypeMapper<float_sylph_t> {
-  typedef QuaternionData_NoFlyWeight<float_sylph_t> res_t;
-};
-
 #include "algorithm/kalman.h"
 
 #include "navigation/INS_GPS_Factory.h"
+#include "navigation/EGM_Grid.h"
 #include "navigation/INS_GPS_Synchronization.h"
 #include "navigation/INS_GPS_Debug.h"
 
@@ -234,6 +260,9 @@ struct Options : public GlobalOptions<float_sylph_t> {
   bool est_bias; ///< True for performing bias estimation
   bool use_udkf; ///< True for UD Kalman filtering
   bool use_egm; ///< True for precise Earth gravity model
+  typedef EGM_Grid<EGM2008_70_Generic<float_sylph_t> > egm_t;
+  egm_t::grid_t *egm_grid; ///< Precomputed gravity grid
+  Filtered_INS2_MultiRate_Property<float_sylph_t> multi_rate_property;
 
   INS_GPS_Back_Propagate_Property<float_sylph_t> back_propagate_property;
   INS_GPS_RealTime_Property<float_sylph_t> realttime_property;
@@ -282,6 +311,10 @@ struct Options : public GlobalOptions<float_sylph_t> {
   } initial_attitude;
   std::istream *init_misc; ///< other manual initialization
   std::stringstream init_misc_buf; ///< buffer for init_misc string
+  std::string init_misc_content; ///< loaded manual initialization, which is shared by all logs
+
+  // Multiple logs
+  int threads; ///< Number of worker threads, or 0 for the number of CPU cores
 
   // Debug
   INS_GPS_Debug_Property<float_sylph_t> debug_property;
@@ -292,7 +325,8 @@ struct Options : public GlobalOptions<float_sylph_t> {
       out_is_N_packet(false),
       time_stamp(),
       ins_gps_sync_strategy(INS_GPS_SYNC_OFFLINE),
-      est_bias(true), use_udkf(false), use_egm(false),
+      est_bias(true), use_udkf(false), use_egm(false), egm_grid(NULL),
+      multi_rate_property(),
       back_propagate_property(),
       realttime_property(),
       gps_fake_lock(false), gps_threshold(),
@@ -300,11 +334,24 @@ struct Options : public GlobalOptions<float_sylph_t> {
       mag_heading_accuracy_deg(3),
       yaw_correct_with_mag_when_speed_less_than_ms(5),
       initial_attitude(),
-      init_misc_buf(), init_misc(&init_misc_buf),
+      init_misc_buf(), init_misc(&init_misc_buf), init_misc_content(),
+      threads(0),
       debug_property() {
     realttime_property.rt_mode = INS_GPS_RealTime_Property<float_sylph_t>::RT_LIGHT_WEIGHT;
   }
-  ~Options(){}
+  ~Options(){
+    delete egm_grid;
+  }
+
+  /**
+   * Load manual initialization at once
+   * so that each log can be initialized with the same contents independently.
+   */
+  void load_init_misc(){
+    std::stringstream ss;
+    ss << init_misc->rdbuf();
+    init_misc_content = ss.str();
+  }
 
   /**
    * Check spec
@@ -360,6 +407,26 @@ CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
     CHECK_OPTION_BOOL(est_bias);
     CHECK_OPTION_BOOL(use_udkf);
     CHECK_OPTION_BOOL(use_egm);
+    CHECK_OPTION(egm_grid, false,
+        {
+          delete egm_grid;
+          egm_grid = NULL;
+          try{
+            egm_grid = new egm_t::grid_t(value);
+          }catch(std::ios_base::failure &e){
+            std::cerr << "(error!) egm_grid: " << e.what() << std::endl;
+            return false;
+          }
+          egm_grid->activate();
+          use_egm = true;
+        },
+        value << " (interpolation error: "
+          << egm_grid->header->max_error[0] << ", "
+          << egm_grid->header->max_error[1] << ", "
+          << egm_grid->header->max_error[2] << " [m/s^2])");
+    CHECK_OPTION(predict_interval, false,
+        multi_rate_property.predict_interval = std::atof(value),
+        multi_rate_property.predict_interval << " [s]");
     CHECK_OPTION(bp_depth, false,
         back_propagate_property.back_propagate_depth = std::atof(value),
         back_propagate_property.back_propagate_depth);
@@ -403,6 +470,10 @@ CHECK_OPTION(target, true, target = is_true(value), (target ? "on" : "off"));
         {std::cerr << "Checking... "; init_misc = &spec2istream(value);},
         value);
 
+    CHECK_OPTION(threads, false,
+        threads = std::atoi(value),
+        threads);
+
     CHECK_OPTION(debug, false,
         if(!debug_property.check_debug_property_spec(value)){break;},
         debug_property.show_debug_property());
@@ -471,7 +542,21 @@ class NAV : public Updatable {
   public:
     typedef NAVData<float_sylph_t> data_t;
     typedef std::vector<const data_t *> updated_items_t;
+  protected:
+    std::ostream *_out; ///< Pointer for output stream
+    std::ostream *_out_debug; ///< Pointer for debug output stream
+  public:
+    NAV() : _out(&options.out()), _out_debug(&options.out_debug()) {}
     virtual ~NAV(){}
+    /**
+     * Change output streams, which are global ones by default.
+     */
+    void set_output(std::ostream &out, std::ostream &out_debug){
+      _out = &out;
+      _out_debug = &out_debug;
+    }
+    std::ostream &out() const {return *_out;}
+    std::ostream &out_debug() const {return *_out_debug;}
   public:
     virtual void label(std::ostream &out) const = 0;
     virtual updated_items_t updated_items() const {
@@ -508,10 +593,9 @@ class NAV : public Updatable {
         const float_sylph_t &latitude, const float_sylph_t &longitude, const float_sylph_t &altitude){
 
       typedef Vector3<float_sylph_t> vec_t;
-      typedef Quaternion<float_sylph_t> quat_t;
 
       // Cancel attitude (inverted)
-      vec_t mag_horizontal((attitude * quat_t(0, mag) * attitude.conj()).vector());
+      vec_t mag_horizontal(attitude.rotate(mag));
 
       // Call Earth's magnetic field model
       MagneticField::field_components_res_t mag_model(
@@ -575,8 +659,8 @@ struct NAV_Factory {
     NAVDisplay() : BaseNAV() {}
     void label(std::ostream &out = std::cout) const {
       if(options.out_is_N_packet){return;}
-      BaseNAV::label(options.out());
-      options.out() << std::endl;
+      BaseNAV::label(NAV::out());
+      NAV::out() << std::endl;
     }
     void updated() const {
       const NAV::updated_items_t &items(BaseNAV::updated_items());
@@ -587,16 +671,16 @@ struct NAV_Factory {
         if(options.out_is_N_packet){
           char buf[SYLPHIDE_PAGE_SIZE];
           (*it)->encode_N0(buf);
-          options.out().write(buf, sizeof(buf));
+          NAV::out().write(buf, sizeof(buf));
           return;
         }else{
-          options.out() << (**it) << std::endl;
+          NAV::out() << (**it) << std::endl;
         }
       }
 
-      options.out_debug() << (**(items.rbegin())).time_stamp() << ',';
-      BaseNAV::inspect(options.out_debug());
-      options.out_debug() << std::endl;
+      NAV::out_debug() << (**(items.rbegin())).time_stamp() << ',';
+      BaseNAV::inspect(NAV::out_debug());
+      NAV::out_debug() << std::endl;
     }
 #define update_func(type) \
 virtual void update(const type &packet){ \
@@ -758,6 +842,8 @@ class INS_GPS_NAV : public NAV {
         
         ins_gps->getFilter().setQ(Q);
       }
+
+      ins_gps->setup_multi_rate(options.multi_rate_property);
     }
 
     void setup_filter(
@@ -1256,8 +1342,7 @@ class INS_GPS_NAVData : public INS_GPS {
         std::ostream &out, const Filtered_INS_BiasEstimated<BaseFINS> *fins) const {
       dump2(out, (const BaseFINS *)fins);
       if(options.dump_stddev){
-        const mat_t &P(
-            const_cast<Filtered_INS_BiasEstimated<BaseFINS> *>(fins)->getFilter().getP());
+        const mat_t &P(fins->getFilter_unpropagated().getP());
         for(int i(Filtered_INS_BiasEstimated<BaseFINS>::P_SIZE_WITHOUT_BIAS), j(0);
             j < Filtered_INS_BiasEstimated<BaseFINS>::P_SIZE_BIAS; ++i, ++j){
           out << ',' << sqrt(P(i, i));
@@ -1578,11 +1663,16 @@ class StreamProcessor
   protected:
     int invoked;
     istream *in;
+    MappedFile::page_reader_t in_pages; ///< pages of memory mapped log, used when in is NULL
     
   public:
+    ostream *out; ///< log specific output, NULL means global one
+    ostream *out_debug; ///< log specific debug output, NULL means global one
+
     StreamProcessor()
         : super_t(), updatable(&updatable_blackhole),
-        in(NULL), invoked(0),
+        in(NULL), in_pages(), invoked(0),
+        out(NULL), out_debug(NULL),
         a_handler(*this),
         g_handler(*this),
         m_handler(*this) {
@@ -1590,7 +1680,8 @@ class StreamProcessor
     }
     StreamProcessor(const StreamProcessor &another)
         : super_t(another), updatable(another.updatable),
-        in(another.in), invoked(another.invoked),
+        in(another.in), in_pages(another.in_pages), invoked(another.invoked),
+        out(another.out), out_debug(another.out_debug),
         a_handler(*this),
         g_handler(*this),
         m_handler(*this) {
@@ -1612,6 +1703,16 @@ class StreamProcessor
       return in;
     }
 
+    /**
+     * Use memory mapped log as input instead of stream
+     *
+     * @param pages pages of mapped log, which must be alive while processing
+     */
+    void input(const MappedFile::page_reader_t &pages) {
+      in = NULL;
+      in_pages = pages;
+    }
+
     /**
      * Process stream in units of 1 page
      * 
@@ -1619,12 +1720,19 @@ class StreamProcessor
      * @return (bool) true when success, otherwise false.
      */
     bool process_1page(){
-      char buffer[SYLPHIDE_PAGE_SIZE];
+      char buffer_copied[SYLPHIDE_PAGE_SIZE];
+      const char *buffer(buffer_copied);
       
       int read_count;
-      in->read(buffer, SYLPHIDE_PAGE_SIZE);
-      read_count = static_cast<int>(in->gcount());
-      if(in->fail() || (read_count == 0)){return false;}
+      if(in){
+        in->read(buffer_copied, SYLPHIDE_PAGE_SIZE);
+        read_count = static_cast<int>(in->gcount());
+        if(in->fail() || (read_count == 0)){return false;}
+      }else{
+        // zero-copy; buffer directly points to the mapped page.
+        read_count = static_cast<int>(in_pages.next(buffer));
+        if(read_count < SYLPHIDE_PAGE_SIZE){return false;} // the same as truncated stream
+      }
       invoked++;
     
 #if DEBUG
@@ -1694,6 +1802,20 @@ class StreamProcessor
         return true;
       }
 
+      if(value = Options::get_value(spec, "log_out", false)){ // Output
+        if(dry_run){return true;}
+        std::cerr << "log_out: ";
+        out = &options.spec2ostream(value);
+        return true;
+      }
+
+      if(value = Options::get_value(spec, "log_out_debug", false)){ // Debug output
+        if(dry_run){return true;}
+        std::cerr << "log_out_debug: ";
+        out_debug = &options.spec2ostream(value);
+        return true;
+      }
+
       return false;
     }
 };
@@ -1816,22 +1938,22 @@ class INS_GPS_NAV<INS_GPS>::Helper {
           float_t itow(recent_a.buf.back().itow);
           typedef typename INS_GPS_Back_Propagate<Base_INS_GPS>::snapshots_t snapshots_t;
           const snapshots_t &snapshots(ins_gps->get_snapshots());
-          int index(0);
-          for(typename snapshots_t::const_iterator it(snapshots.begin());
-              it != snapshots.end();
-              ++it, index++){
-            if(it->elapsedT_from_last_correct >= options.back_propagate_property.back_propagate_depth){
+          for(unsigned int index(0); index < snapshots.size(); index++){
+            float_t elapsedT(snapshots[index].elapsedT_from_last_correct);
+            if(elapsedT >= options.back_propagate_property.back_propagate_depth){
               break;
             }
 
             if(index == 0){
               if(!options.dump_correct){continue;}
-              it->ins_gps.set_header("BP_MU", t_stamp_generator(itow + it->elapsedT_from_last_correct));
-              res.push_back(&(it->ins_gps));
+              const Base_INS_GPS &restored(ins_gps->restore_snapshot(index));
+              restored.set_header("BP_MU", t_stamp_generator(itow + elapsedT));
+              res.push_back(&restored);
             }else{
               if(!options.dump_update){continue;}
-              it->ins_gps.set_header("BP_TU",  t_stamp_generator(itow + it->elapsedT_from_last_correct));
-              res.push_back(&(it->ins_gps));
+              const Base_INS_GPS &restored(ins_gps->restore_snapshot(index));
+              restored.set_header("BP_TU",  t_stamp_generator(itow + elapsedT));
+              res.push_back(&restored);
             }
           }
           break;
@@ -1972,8 +2094,9 @@ class INS_GPS_NAV<INS_GPS>::Helper {
       nav.ins_gps->initVelocity(v_north, v_east, v_down);
       nav.ins_gps->initAttitude(yaw, pitch, roll);
 
-      for(char buf[0x4000]; !options.init_misc->eof(); ){ // Miscellaneous setup
-        options.init_misc->getline(buf, sizeof(buf));
+      std::istringstream init_misc(options.init_misc_content);
+      for(char buf[0x4000]; !init_misc.eof(); ){ // Miscellaneous setup
+        init_misc.getline(buf, sizeof(buf));
         nav.init_misc(buf);
       }
     }
@@ -2054,51 +2177,193 @@ class INS_GPS_NAV<INS_GPS>::Helper {
 
 class NAV_Generator {
   private:
+    typedef StandardCalibration<float_sylph_t> calibration_t;
     template <class T>
-    static NAV *final(){
-      return INS_GPS_NAV_Factory<typename T::product>::get_nav(processors.front().calibration());
+    static NAV *final(const calibration_t &calibration){
+      return INS_GPS_NAV_Factory<typename T::product>::get_nav(calibration);
     }
     template <class T>
-    static NAV *check_bias(){
-      return options.est_bias ? final<typename T::template bias<> >() : final<T>();
+    static NAV *check_bias(const calibration_t &calibration){
+      return options.est_bias
+          ? final<typename T::template bias<> >(calibration)
+          : final<T>(calibration);
     }
     template <class T>
-    static NAV *check_udkf(){
+    static NAV *check_udkf(const calibration_t &calibration){
       return options.use_udkf
-          ? check_bias<typename T::template kf<KalmanFilterUD> >()
-          : check_bias<typename T::template kf<KalmanFilter> >();
+          ? check_bias<typename T::template kf<KalmanFilterUD> >(calibration)
+          : check_bias<typename T::template kf<KalmanFilter> >(calibration);
     }
     template <class T>
-    static NAV *check_egm(){
-      return options.use_egm ? check_udkf<typename T::template egm<> >() : check_udkf<T>();
+    static NAV *check_egm(const calibration_t &calibration){
+      return options.use_egm
+          ? check_udkf<typename T::template egm<Options::egm_t> >(calibration)
+          : check_udkf<T>(calibration);
     }
   public:
-    static NAV *generate(){
+    static NAV *generate(const calibration_t &calibration){
       switch(options.time_stamp.mode){
         case Options::time_stamp_t::CALENDAR_TIME:
           return check_egm<INS_GPS_Factory<
-              INS_NAVData<INS<float_sylph_t>, CalendarTimeStamp<float_sylph_t> > > >();
+              INS_NAVData<INS<float_sylph_t>, CalendarTimeStamp<float_sylph_t> > > >(calibration);
         case Options::time_stamp_t::ITOW:
         default:
           return check_egm<INS_GPS_Factory<
-              INS_NAVData<INS<float_sylph_t> > > >();
+              INS_NAVData<INS<float_sylph_t> > > >(calibration);
+      }
+    }
+};
+
+/**
+ * Time ordered queue of packets of a type, whose capacity is fixed.
+ * Packets are stored by value in a ring buffer.
+ *
+ * @param T packet type
+ */
+template <class T>
+class PacketQueue {
+  public:
+    struct entry_t {
+      T packet;
+      unsigned int serial; ///< arrival order
+    };
+  protected:
+    vector<entry_t> ring;
+    unsigned int head, length;
+    entry_t &at(const unsigned int &i) {
+      return ring[(head + i) % ring.size()];
+    }
+  public:
+    PacketQueue(const unsigned int &capacity)
+        : ring(capacity), head(0), length(0) {}
+    bool empty() const {return length == 0;}
+    unsigned int size() const {return length;}
+    const entry_t &front() const {return ring[head];}
+    void pop_front() {
+      if(++head >= ring.size()){head = 0;}
+      --length;
+    }
+    /**
+     * Insert a packet in time order.
+     * Packets of a type usually arrive in order, therefore the search starts from the back.
+     * A packet having the same time as the queued ones is placed after them.
+     */
+    void push(const T &packet, const unsigned int &serial) {
+      unsigned int i(length++);
+      for(; i > 0; --i){
+        entry_t &prev(at(i - 1));
+        if(!Packet::compare_rollover(&packet, &prev.packet)){break;}
+        at(i) = prev;
+      }
+      entry_t &target(at(i));
+      target.packet = packet;
+      target.serial = serial;
+    }
+};
+
+/**
+ * Reorder packets of all types in time order and apply them to a NAV.
+ * Each type has its own queue, and the earliest packet among the queue heads
+ * is applied when the total number of queued packets exceeds the depth.
+ * Therefore, a packet can be reordered against at most depth packets which arrived before it,
+ * and it is applied after at most depth packets arrive after it.
+ * Packets having the same time are applied in arrival order.
+ */
+class PacketMerger : public Updatable {
+  public:
+    static const unsigned int depth = 0x100;
+  protected:
+    NAV &nav;
+    unsigned int serial;
+    PacketQueue<A_Packet> queue_A;
+    PacketQueue<G_Packet> queue_G;
+    PacketQueue<M_Packet> queue_M;
+    PacketQueue<TimePacket> queue_Time;
+
+    unsigned int size() const {
+      return queue_A.size() + queue_G.size() + queue_M.size() + queue_Time.size();
+    }
+
+    template <class T>
+    static void select(
+        const PacketQueue<T> &queue, const int &index,
+        int &selected, const Packet *&packet, unsigned int &packet_serial){
+      if(queue.empty()){return;}
+      const typename PacketQueue<T>::entry_t &entry(queue.front());
+      if(packet){
+        if(Packet::compare_rollover(packet, &entry.packet)){return;}
+        if((!Packet::compare_rollover(&entry.packet, packet))
+            && ((int)(entry.serial - packet_serial) > 0)){return;} // same time, but arrived later
       }
+      selected = index;
+      packet = &entry.packet;
+      packet_serial = entry.serial;
+    }
+
+    template <class T>
+    void apply_front(PacketQueue<T> &queue){
+      nav.update(queue.front().packet);
+      queue.pop_front();
     }
+
+    /**
+     * Apply the earliest packet, which is found by k-way merge of the queue heads.
+     * Because the number of the queues is small, linear search is used instead of heap.
+     */
+    void apply_earliest(){
+      int selected(-1);
+      const Packet *packet(NULL);
+      unsigned int packet_serial(0);
+      select(queue_A, 0, selected, packet, packet_serial);
+      select(queue_G, 1, selected, packet, packet_serial);
+      select(queue_M, 2, selected, packet, packet_serial);
+      select(queue_Time, 3, selected, packet, packet_serial);
+      switch(selected){
+        case 0: apply_front(queue_A); break;
+        case 1: apply_front(queue_G); break;
+        case 2: apply_front(queue_M); break;
+        case 3: apply_front(queue_Time); break;
+      }
+    }
+
+    template <class T>
+    void push(PacketQueue<T> &queue, const T &packet){
+      queue.push(packet, serial++);
+      if(size() > depth){apply_earliest();}
+    }
+
+  public:
+    PacketMerger(NAV &_nav)
+        : nav(_nav), serial(0),
+        queue_A(depth + 1), queue_G(depth + 1), queue_M(depth + 1), queue_Time(depth + 1) {}
+    ~PacketMerger() {
+      while(size() > 0){apply_earliest();}
+    }
+    void update(const A_Packet &packet){push(queue_A, packet);}
+    void update(const G_Packet &packet){push(queue_G, packet);}
+    void update(const M_Packet &packet){push(queue_M, packet);}
+    void update(const TimePacket &packet){push(queue_Time, packet);}
 };
 
-void loop(){
+/**
+ * Process a log, which is independent of the other logs.
+ * Output streams of the processor must be resolved before invocation.
+ *
+ * @param proc processor of the log
+ */
+void loop(StreamProcessor &proc){
   struct NAV_Manager {
     NAV *nav;
-    NAV_Manager() : nav(NAV_Generator::generate()){}
+    NAV_Manager(const StreamProcessor &proc)
+        : nav(NAV_Generator::generate(proc.calibration())){}
     ~NAV_Manager(){
       delete nav;
     }
-  } nav_manager;
+  } nav_manager(proc);
   
-  nav_manager.nav->label(options.out());
+  nav_manager.nav->set_output(*proc.out, *proc.out_debug);
+  nav_manager.nav->label(*proc.out);
 
-  // TODO multiple log stream will be support.
-  StreamProcessor &proc(processors.front());
   if(options.ins_gps_sync_strategy == Options::INS_GPS_SYNC_REALTIME){
     // Realtime mode supports only one stream.
     proc.update_target() = nav_manager.nav;
@@ -2106,43 +2371,24 @@ void loop(){
     return;
   }
 
-  struct buffer_t : public Updatable {
-    typedef deque<const Packet *> packet_pool_t;
-    packet_pool_t packet_pool;
-    NAV &nav;
-    void sort_and_apply(int packets){
-      stable_sort(packet_pool.begin(), packet_pool.end(), Packet::compare_rollover);
-      while(packets-- > 0){
-        packet_pool_t::reference front(packet_pool.front());
-        front->apply(nav);
-        delete front;
-        packet_pool.pop_front();
-      }
-    }
-    void sort_and_apply2 () {
-      if(packet_pool.size() < 0x200){return;}
-      sort_and_apply(0x100);
-    }
-    buffer_t(NAV &_nav) : packet_pool(), nav(_nav) {}
-    ~buffer_t() {
-      sort_and_apply(packet_pool.size());
-    }
-#define update_func(type) \
-virtual void update(const type &packet){ \
-  packet_pool.push_back(new type(packet)); \
-  sort_and_apply2(); \
-}
-    update_func(A_Packet);
-    update_func(G_Packet);
-    update_func(M_Packet);
-    update_func(TimePacket);
-#undef update_func
-  } buffer(*nav_manager.nav);
+  PacketMerger buffer(*nav_manager.nav);
   proc.update_target() = &buffer;
 
   while(proc.process_1page());
 }
 
+#if defined(INS_GPS_USE_THREAD)
+struct loop_worker_t {
+  vector<StreamProcessor *> &jobs;
+  std::atomic<unsigned int> &index;
+  void operator()(){
+    for(unsigned int i; (i = index++) < jobs.size(); ){
+      loop(*jobs[i]);
+    }
+  }
+};
+#endif
+
 int main(int argc, char *argv[]){
   
   cout << setprecision(10);
@@ -2190,9 +2436,15 @@ int main(int argc, char *argv[]){
       if(options.check_spec(argv[arg_index])){continue;}
 
       cerr << "Log file(" << processors.size() << "): ";
-      istream &in(options.spec2istream(argv[arg_index]));
-      stream_processor.input()
-          = options.in_sylphide ? new SylphideIStream(in, SYLPHIDE_PAGE_SIZE) : &in;
+      const MappedFile *mapped(
+          options.in_sylphide ? NULL : options.spec2mapped(argv[arg_index]));
+      if(mapped){
+        stream_processor.input(options.spec2pages(argv[arg_index], *mapped));
+      }else{
+        istream &in(options.spec2istream(argv[arg_index]));
+        stream_processor.input()
+            = options.in_sylphide ? new SylphideIStream(in, SYLPHIDE_PAGE_SIZE) : &in;
+      }
 
       for(args_t::const_iterator it(args_proc.begin());
           it != args_proc.end(); ++it){
@@ -2217,19 +2469,78 @@ int main(int argc, char *argv[]){
     cerr << "(error!) No log file." << endl;
     exit(-1);
   }
-  if(processors.size() > 1){ // TODO multiple log stream will be support.
-    cerr << "(error!) too many log." << endl;
+
+  if((options.multi_rate_property.predict_interval > 0)
+      && (options.ins_gps_sync_strategy != Options::INS_GPS_SYNC_OFFLINE)){
+    // Their snapshots assume the covariance propagation at every step.
+    cerr << "(error!) --predict_interval is not supported with --back_propagate or --realtime." << endl;
     exit(-1);
   }
 
-  if(options.out_sylphide){
-    options._out = new SylphideOStream(options.out(), SYLPHIDE_PAGE_SIZE);
-  }else{
-    options.out() << setprecision(10);
+  // Resolve output of each log; multiple logs require their own outputs.
+  bool is_multiple(processors.size() > 1);
+  vector<StreamProcessor *> jobs;
+  struct Stream_Manager { // owns streams generated for each log
+    vector<ostream *> streams;
+    ostream *manage(ostream *stream){
+      streams.push_back(stream);
+      return stream;
+    }
+    ~Stream_Manager(){
+      for(vector<ostream *>::iterator it(streams.begin()); it != streams.end(); ++it){
+        delete *it;
+      }
+    }
+  } stream_manager;
+  for(list<StreamProcessor>::iterator it(processors.begin());
+      it != processors.end(); ++it){
+    if(!it->out){
+      if(is_multiple){
+        cerr << "(error!) --log_out is required for each log when multiple logs are given." << endl;
+        exit(-1);
+      }
+      it->out = &options.out();
+    }
+    if(options.out_sylphide){
+      it->out = stream_manager.manage(
+          new SylphideOStream(*it->out, SYLPHIDE_PAGE_SIZE));
+    }else{
+      (*it->out) << setprecision(10);
+    }
+    if(!it->out_debug){
+      // Shared debug output is disabled to prevent results from being mixed.
+      it->out_debug = is_multiple
+          ? stream_manager.manage(new NullStream())
+          : &options.out_debug();
+    }
+    (*it->out_debug) << setprecision(16);
+    jobs.push_back(&(*it));
+  }
+
+  options.load_init_misc();
+
+#if defined(INS_GPS_USE_THREAD)
+  unsigned int threads((options.threads > 0)
+      ? options.threads
+      : std::thread::hardware_concurrency());
+  if(threads > jobs.size()){threads = jobs.size();}
+  if(threads > 1){
+    std::atomic<unsigned int> index(0);
+    vector<std::thread> workers;
+    for(unsigned int i(0); i < threads; ++i){
+      loop_worker_t worker = {jobs, index};
+      workers.push_back(std::thread(worker));
+    }
+    for(vector<std::thread>::iterator it(workers.begin()); it != workers.end(); ++it){
+      it->join();
+    }
+    return 0;
   }
-  options.out_debug() << setprecision(16);
+#endif
 
-  loop();
+  for(vector<StreamProcessor *>::iterator it(jobs.begin()); it != jobs.end(); ++it){
+    loop(**it);
+  }
 
   return 0;
 }
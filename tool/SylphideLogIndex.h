@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2017, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** @file
+ * @brief Sidecar index of a NinjaScan log for random access by GPS time
+ *
+ * A log consists of fixed size pages, whose time stamps are available only after decoding.
+ * The index, which is generated in advance by log_index, holds the time stamp of
+ * every N pages, then analysis of a short time range can start near the range
+ * instead of decoding the whole log from its beginning.
+ */
+
+#ifndef __SYLPHIDE_LOG_INDEX_H__
+#define __SYLPHIDE_LOG_INDEX_H__
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "SylphideProcessor.h"
+
+/**
+ * Index of a log.
+ * Each entry corresponds to the head of a page and holds the latest time stamp and
+ * GPS week number appearing before the page.
+ */
+struct SylphideLogIndex {
+  struct header_t {
+    char magic[8]; ///< "SYLPIDX"
+    int version;
+    int page_size;
+    unsigned int interval; ///< number of pages between entries
+    unsigned int pages; ///< number of pages of the indexed log, used to detect a stale index
+
+    static const int current_version = 1;
+
+    header_t(const unsigned int &_interval = 0x100, const unsigned int &_pages = 0)
+        : version(current_version), page_size(SYLPHIDE_PAGE_SIZE),
+        interval(_interval), pages(_pages) {
+      std::memcpy(magic, "SYLPIDX", sizeof(magic));
+    }
+    bool is_valid() const {
+      return (std::memcmp(magic, "SYLPIDX", sizeof(magic)) == 0)
+          && (version == current_version)
+          && (page_size == SYLPHIDE_PAGE_SIZE)
+          && (interval > 0);
+    }
+  };
+
+  struct entry_t {
+    unsigned int page; ///< page number, whose byte offset is page * page_size
+    int week; ///< GPS week number, or negative when unknown
+    double itow; ///< GPS time of week [s], or negative when unknown
+    char type; ///< the first character of the page, such as 'A' and 'G'
+    char reserved[7];
+  };
+
+  header_t header;
+  std::vector<entry_t> entries;
+  double margin; ///< time [s] to be processed before the requested start to rebuild observer states
+
+  SylphideLogIndex() : header(), entries(), margin(10) {}
+
+  /**
+   * File name of the index for a log
+   */
+  static std::string index_fname(const char *log_fname){
+    return std::string(log_fname).append(".idx");
+  }
+
+  /**
+   * Load an index
+   *
+   * @param in input
+   * @return (bool) true when a valid index is loaded
+   */
+  bool load(std::istream &in){
+    entries.clear();
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if((in.gcount() != sizeof(header)) || !header.is_valid()){return false;}
+    entry_t entry;
+    while(in.read(reinterpret_cast<char *>(&entry), sizeof(entry)).gcount() == sizeof(entry)){
+      entries.push_back(entry);
+    }
+    return true;
+  }
+
+  void save(std::ostream &out) const {
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if(entries.empty()){return;}
+    out.write(reinterpret_cast<const char *>(&entries[0]), sizeof(entry_t) * entries.size());
+  }
+
+  /**
+   * Index generator, to which pages are supplied in order.
+   * Time stamps are obtained from A pages, which are the most frequent, and GPS week number is
+   * obtained from NAV-SOL and NAV-TIMEGPS in G pages.
+   */
+  template <class FloatType = double>
+  class Generator : protected AbstractSylphideProcessor<FloatType> {
+    protected:
+      typedef AbstractSylphideProcessor<FloatType> super_t;
+      typedef G_Packet_Observer<FloatType> G_Observer_t;
+      SylphideLogIndex &index;
+      G_Observer_t observer_G;
+      bool previous_seek_next_G;
+      unsigned int page;
+      int week;
+      double itow;
+
+      struct HandlerG {
+        int &week;
+        void operator()(const G_Observer_t &observer){
+          if(!observer.validate()){return;}
+          typename G_Observer_t::packet_type_t packet_type(observer.packet_type());
+          if(packet_type.mclass != 0x01){return;}
+          switch(packet_type.mid){
+            case 0x06: { // NAV-SOL
+              typename G_Observer_t::solution_t solution(observer.fetch_solution());
+              if(solution.status_flags & G_Observer_t::solution_t::WN_VALID){
+                week = solution.week;
+              }
+              break;
+            }
+            case 0x20: { // NAV-TIMEGPS
+              char buf[4];
+              observer.inspect(buf, sizeof(buf), 6 + 8);
+              if((unsigned char)buf[3] & 0x02){ // valid week number
+                week = le_char2_2_num<unsigned short>(*buf);
+              }
+              break;
+            }
+          }
+        }
+      };
+
+      static unsigned int le_u32(const char *buf){
+        return (unsigned int)(unsigned char)buf[0]
+            | ((unsigned int)(unsigned char)buf[1] << 8)
+            | ((unsigned int)(unsigned char)buf[2] << 16)
+            | ((unsigned int)(unsigned char)buf[3] << 24);
+      }
+
+    public:
+      Generator(SylphideLogIndex &_index, const unsigned int &interval = 0x100)
+          : super_t(), index(_index),
+          observer_G(SYLPHIDE_PAGE_SIZE * 32),
+          previous_seek_next_G(observer_G.ready()),
+          page(0), week(-1), itow(-1) {
+        index.header = header_t(interval);
+        index.entries.clear();
+      }
+
+      /**
+       * Process a page
+       *
+       * @param buf page, whose size must be SYLPHIDE_PAGE_SIZE
+       */
+      void process(const char *buf){
+        if((page % index.header.interval) == 0){
+          entry_t entry = entry_t();
+          entry.page = page;
+          entry.week = week;
+          entry.itow = itow;
+          entry.type = buf[0];
+          index.entries.push_back(entry);
+        }
+        ++page;
+        index.header.pages = page;
+        switch(buf[0]){
+          case 'A':
+            itow = 1E-3 * le_u32(buf + 2);
+            break;
+          case 'G': {
+            HandlerG handler = {week};
+            super_t::process_packet(
+                buf, SYLPHIDE_PAGE_SIZE, observer_G, previous_seek_next_G, handler);
+            break;
+          }
+        }
+      }
+  };
+
+  /**
+   * Find a page from which processing should start.
+   * Every entry before the returned one is earlier than the requested start by more than margin.
+   *
+   * @param range time range, which has is_time_after_start(itow, week) such as GlobalOptions
+   * @return (unsigned int) page number
+   */
+  template <class TimeRange>
+  unsigned int start_page(const TimeRange &range) const {
+    unsigned int res(0);
+    for(typename std::vector<entry_t>::const_iterator it(entries.begin());
+        it != entries.end(); ++it){
+      if((it->itow >= 0) && range.is_time_after_start(it->itow + margin, it->week)){break;}
+      res = it->page;
+    }
+    return res;
+  }
+
+  /**
+   * Find a page at which processing can stop.
+   *
+   * @param range time range, which has is_time_before_end(itow, week) such as GlobalOptions
+   * @return (unsigned int) page number, which equals to the number of pages
+   * when the whole log should be processed
+   */
+  template <class TimeRange>
+  unsigned int end_page(const TimeRange &range) const {
+    for(typename std::vector<entry_t>::const_iterator it(entries.begin());
+        it != entries.end(); ++it){
+      if((it->itow >= 0) && !range.is_time_before_end(it->itow - margin, it->week)){
+        return it->page;
+      }
+    }
+    return header.pages;
+  }
+};
+
+#endif /* __SYLPHIDE_LOG_INDEX_H__ */
@@ -56,11 +56,68 @@
 
 template <class Container = char>
 class Packet_Observer : public FIFO<Container>{
+  protected:
+    typedef FIFO<Container> fifo_t;
+    const Container *page_head; ///< page observed in place, or NULL when FIFO is used
+    unsigned int page_stored;
   public:
+    /**
+     * Size of a packet which always fits in a single page.
+     * Non-zero value enables zero-copy observation with attach().
+     */
+    static const unsigned int direct_packet_size = 0;
+
     Packet_Observer(const unsigned int &buffer_size)
-      : FIFO<Container>(buffer_size){
+      : FIFO<Container>(buffer_size),
+        page_head(NULL), page_stored(0) {
         
     }
+    Packet_Observer(const Packet_Observer &orig)
+      : FIFO<Container>(orig),
+        page_head(NULL), page_stored(0) {
+
+    }
+    Packet_Observer &operator=(const Packet_Observer &another){
+      fifo_t::operator=(another);
+      return *this;
+    }
+
+    /**
+     * Observe a page directly without copying it into FIFO.
+     * Until detach() is called, the page must be kept alive.
+     *
+     * @param page head of the page
+     * @param size page size
+     */
+    void attach(const Container *page, const unsigned int &size){
+      page_head = page;
+      page_stored = size;
+    }
+    void detach(){
+      page_head = NULL;
+    }
+
+    int stored() const {
+      return page_head ? (int)page_stored : fifo_t::stored();
+    }
+    bool is_empty() const {
+      return page_head ? (page_stored == 0) : fifo_t::is_empty();
+    }
+    unsigned int inspect(
+        Container *buffer,
+        unsigned int size,
+        const unsigned int &offset = 0) const {
+      if(!page_head){return fifo_t::inspect(buffer, size, offset);}
+      if(buffer == NULL){return 0;}
+      if(page_stored <= offset){return 0;}
+      size = min_macro(page_stored - offset, size);
+      std::memcpy(buffer, page_head + offset, sizeof(Container) * size);
+      return size;
+    }
+    const Container &operator[](const int &index) const {
+      if(!page_head){return fifo_t::operator[](index);}
+      return page_head[(index >= 0) ? index : ((int)page_stored + index)];
+    }
     virtual ~Packet_Observer(){}
     
     virtual bool ready() const = 0;
@@ -81,6 +138,7 @@ template <class FloatType = double>
 class A_Packet_Observer : public Packet_Observer<>{
   public:
     static const unsigned int a_packet_size = SYLPHIDE_PAGE_SIZE - 1;
+    static const unsigned int direct_packet_size = a_packet_size;
     A_Packet_Observer(const unsigned int &buffer_size) 
         : Packet_Observer<>(buffer_size){
       
@@ -139,6 +197,7 @@ template <class FloatType = double>
 class F_Packet_Observer : public Packet_Observer<>{
   public:
     static const unsigned int f_packet_size = SYLPHIDE_PAGE_SIZE - 1;
+    static const unsigned int direct_packet_size = f_packet_size;
     F_Packet_Observer(const unsigned int &buffer_size) 
         : Packet_Observer<>(buffer_size){
       
@@ -196,6 +255,7 @@ template <class FloatType = double>
 class Data24Bytes_Packet_Observer : public Packet_Observer<>{
   public:
     static const unsigned int packet_size = SYLPHIDE_PAGE_SIZE - 1;
+    static const unsigned int direct_packet_size = packet_size;
     Data24Bytes_Packet_Observer(const unsigned int &buffer_size) 
         : Packet_Observer<>(buffer_size){
       
@@ -1161,6 +1221,7 @@ template <class FloatType = double>
 class N_Packet_Observer : public Packet_Observer<>{
   public:
     static const unsigned int n_packet_size = SYLPHIDE_PAGE_SIZE - 1;
+    static const unsigned int direct_packet_size = n_packet_size;
     N_Packet_Observer(const unsigned int &buffer_size) 
         : Packet_Observer<>(buffer_size){
       
@@ -1283,10 +1344,20 @@ class AbstractSylphideProcessor{
   protected:
     template <class Observer, typename Callback>
     void process_raw(
-        char *buffer, int read_count,
+        const char *buffer, int read_count,
         Observer &observer, 
         bool &previous_seek_next,
         Callback &handler){
+      if((Observer::direct_packet_size > 0)
+          && (read_count == (int)Observer::direct_packet_size)
+          && observer.is_empty()){
+        // A whole packet is in the buffer, then FIFO copy can be skipped.
+        observer.attach(buffer, read_count);
+        handler(observer);
+        observer.detach();
+        previous_seek_next = true;
+        return;
+      }
       observer.write(buffer, read_count);
       if(!previous_seek_next){
         if(observer.ready()){handler(observer);}
@@ -1299,7 +1370,7 @@ class AbstractSylphideProcessor{
     }
     template <class Observer, typename Callback>
     void process_packet(
-        char *buffer, int read_count,
+        const char *buffer, int read_count,
         Observer &observer,
         bool &previous_seek_next,
         Callback &handler){
@@ -71,6 +71,14 @@ struct generic_SylphideProtocol {
       v_u16_t crc_u16 = 0){
     return CRC16::crc16((unsigned char *)&target[offset], size, crc_u16);
   }
+
+  static v_u16_t calc_crc16(
+      const unsigned char *target,
+      const unsigned int &size,
+      const unsigned int &offset,
+      v_u16_t crc_u16 = 0){
+    return CRC16::crc16(&target[offset], size, crc_u16);
+  }
     
   /**
    * GR[hs֐
@@ -469,7 +477,7 @@ typedef generic_SylphideProtocol<> SylphideProtocol;
 #include <ostream>
 #include <cstring>
 
-#include <deque>
+#include <vector>
 
 template<
     class _Elem, 
@@ -567,29 +575,64 @@ template<
 class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
   
   public:
-    class container_t : private std::deque<_Elem>{
+    /**
+     * Contiguous input buffer, on which packets are validated in place.
+     * Characters already available in the input stream are taken in bulk.
+     */
+    class container_t {
       protected:
-        typedef std::deque<_Elem> super_t;
         std::istream &in;
+        std::vector<_Elem> buf;
+        std::size_t head, tail; ///< stored characters are buf[head, tail)
       public:
-        container_t(std::istream &_in) : super_t(), in(_in) {}
+        container_t(std::istream &_in, const std::size_t &capacity = 0x10000)
+            : in(_in), buf(capacity), head(0), tail(0) {}
         ~container_t(){}
         bool pull(unsigned int n){
-          while(n--){
-            _Elem c;
-            in.get(c);
-            if(!in.good()){return false;}
-            super_t::push_back(c);
+          if(tail + n > buf.size()){
+            if(head > 0){ // move stored characters to the head
+              std::memmove(&buf[0], &buf[head], sizeof(_Elem) * (tail - head));
+              tail -= head;
+              head = 0;
+            }
+            if(tail + n > buf.size()){buf.resize(tail + n);}
           }
-          return true;
+          std::streamsize received(in.readsome(&buf[tail], buf.size() - tail));
+          tail += (std::size_t)received;
+          if((unsigned int)received >= n){return true;}
+          n -= (unsigned int)received;
+          in.read(&buf[tail], n); // blocking for only the shortage
+          tail += (std::size_t)in.gcount();
+          return in.good();
         }
         void skip(const unsigned int &n){
-          super_t::erase(super_t::begin(), super_t::begin() + n);
+          if((head += n) >= tail){head = tail = 0;}
         }
-        typename super_t::size_type stored() const {
-          return super_t::size();
+        /**
+         * Skip characters until the next occurrence of a character.
+         *
+         * @param c character to be found
+         * @param offset start position of search
+         * @return (bool) true when found, otherwise all stored characters are skipped.
+         */
+        bool seek(const _Elem &c, const unsigned int &offset = 1){
+          if(tail - head > offset){
+            const _Elem *found((const _Elem *)std::memchr(
+                &buf[head + offset], (unsigned char)c, sizeof(_Elem) * (tail - head - offset)));
+            if(found){
+              head = found - &buf[0];
+              return true;
+            }
+          }
+          head = tail = 0;
+          return false;
         }
-        using super_t::operator[];
+        std::size_t stored() const {
+          return tail - head;
+        }
+        _Elem *data(){return &buf[head];}
+        _Elem &operator[](const std::size_t &i){return buf[head + i];}
+        const _Elem &operator[](const std::size_t &i) const {return buf[head + i];}
     };
   
   protected:
@@ -601,18 +644,8 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
     container_t buffer;
     bool mode_fixed_size; ///< ܂̃pPbgEȂ悤ɂ郂[h
     unsigned int payload_size;
-    _Elem *payload;
-    unsigned int payload_bufsize;
     unsigned int sequence_num;
     
-    void regulate_payload(const unsigned int &min_size){
-      if(payload_bufsize < min_size){
-        delete [] payload;
-        payload_bufsize = min_size;
-        payload = new _Elem[payload_bufsize];
-      }
-    }
-    
     using super_t::eback;
     using super_t::gptr;
     using super_t::egptr;
@@ -633,7 +666,7 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
         }
         if(!header_checked){
           if(!SylphideProtocol::Decorder::valid_head(buffer)){
-            buffer.skip(1);
+            buffer.seek(SylphideProtocol::header[0]); // jump to the next header candidate
           }else{
             header_checked = true;
             buffer_size_min = SylphideProtocol::Decorder::packet_size(buffer);
@@ -641,9 +674,10 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
           continue;
         }
         
-        if(SylphideProtocol::Decorder::validate(buffer)){
+        const unsigned char *packet((const unsigned char *)buffer.data());
+        if(SylphideProtocol::Decorder::validate(packet)){
           unsigned int new_payload_size(
-              SylphideProtocol::Decorder::payload_size(buffer));
+              SylphideProtocol::Decorder::payload_size(packet));
           if(new_payload_size){
             if(mode_fixed_size){
               if(payload_size == new_payload_size){break;}
@@ -654,7 +688,7 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
           }
           buffer.skip(buffer_size_min);
         }else{
-          buffer.skip(1);
+          buffer.seek(SylphideProtocol::header[0]);
         }
         buffer_size_min = SylphideProtocol::capsule_size;
         header_checked = false;
@@ -662,11 +696,10 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
       
       sequence_num
           = SylphideProtocol::Decorder::sequence_num(buffer);
-      regulate_payload(payload_size);
-      
-      SylphideProtocol::Decorder::extract_payload(
-          buffer, payload, buffer_size_min, payload_size);
       
+      // The payload is exposed in place, which remains valid until the next underflow().
+      _Elem *payload(buffer.data()
+          + (buffer_size_min - SylphideProtocol::capsule_tail_size - payload_size));
       setg(payload, payload, payload + payload_size);
       buffer.skip(buffer_size_min);
       
@@ -682,10 +715,9 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
      * @param in ̓Xg[ 
      */
     basic_SylphideStreambuf_in(std::istream &_in)
-        : buffer(_in), payload_size(0),
-        payload(NULL), payload_bufsize(0),
-        sequence_num(0), mode_fixed_size(false) {
-      setg(payload, payload, payload);
+        : buffer(_in), mode_fixed_size(false), payload_size(0),
+        sequence_num(0) {
+      setg(NULL, NULL, NULL);
     }
     /**
      * RXgN^
@@ -697,14 +729,11 @@ class basic_SylphideStreambuf_in : public std::basic_streambuf<_Elem, _Traits>{
      */
     basic_SylphideStreambuf_in(
         std::istream &_in, const unsigned int &size)
-        : buffer(_in), payload_size(size),
-        payload(NULL), payload_bufsize(0),
-        sequence_num(0), mode_fixed_size(size > 0) {
-      setg(payload, payload, payload);
-    }
-    ~basic_SylphideStreambuf_in(){
-      delete [] payload;
+        : buffer(_in), mode_fixed_size(size > 0), payload_size(size),
+        sequence_num(0) {
+      setg(NULL, NULL, NULL);
     }
+    ~basic_SylphideStreambuf_in(){}
     
     const unsigned int &sequence_number() const {
       return sequence_num;
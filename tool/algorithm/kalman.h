@@ -34,6 +34,166 @@
 
 #include "param/matrix.h"
 
+/**
+ * @brief Time update of error covariance matrix utilizing sparsity
+ *
+ * The error covariance matrix is updated as
+ * @f[
+ *   P \leftarrow \Phi P \Phi^{T} + \Gamma Q \Gamma^{T},
+ * @f]
+ * where multiplications by zero elements of @f$ \Phi @f$, @f$ \Gamma @f$, and @f$ Q @f$ are skipped.
+ * Since the skipped terms are exactly zero, and the order of summation is kept
+ * as the same as the product of Matrix, the result is identical to the dense calculation,
+ * while the number of multiplications is greatly reduced for sparse system matrices
+ * such as ones of INS error dynamics.
+ */
+struct KalmanFilter_SparsePredictor {
+  /**
+   * @param P_res buffer for updated @f$ P @f$ (n * n), which can be the same as P
+   * @param P @f$ P @f$ (n * n)
+   * @param Phi @f$ \Phi @f$ (n * n)
+   * @param Gamma @f$ \Gamma @f$ (n * q)
+   * @param Q @f$ Q @f$ (q * q)
+   * @param Phi_P working buffer (n * n)
+   * @param Gamma_Q working buffer (n * q)
+   */
+  template <
+      class MatrixT_P_res, class MatrixT_P,
+      class MatrixT_Phi, class MatrixT_Gamma, class MatrixT_Q,
+      class MatrixT_Phi_P, class MatrixT_Gamma_Q>
+  static void predict(
+      MatrixT_P_res &P_res, const MatrixT_P &P,
+      const MatrixT_Phi &Phi, const MatrixT_Gamma &Gamma, const MatrixT_Q &Q,
+      MatrixT_Phi_P &Phi_P, MatrixT_Gamma_Q &Gamma_Q){
+
+    const unsigned int n(Phi.rows()), q(Gamma.columns());
+
+    // Phi_P = Phi * P
+    for(unsigned int i(0); i < n; ++i){
+      for(unsigned int j(0); j < n; ++j){Phi_P(i, j) = 0;}
+      for(unsigned int k(0); k < n; ++k){
+        if(Phi(i, k) == 0){continue;}
+        for(unsigned int j(0); j < n; ++j){
+          Phi_P(i, j) += Phi(i, k) * P(k, j);
+        }
+      }
+    }
+
+    // Gamma_Q = Gamma * Q
+    for(unsigned int i(0); i < n; ++i){
+      for(unsigned int j(0); j < q; ++j){Gamma_Q(i, j) = 0;}
+      for(unsigned int k(0); k < q; ++k){
+        if(Gamma(i, k) == 0){continue;}
+        for(unsigned int j(0); j < q; ++j){
+          if(Q(k, j) == 0){continue;}
+          Gamma_Q(i, j) += Gamma(i, k) * Q(k, j);
+        }
+      }
+    }
+
+    // P_res = Phi_P * Phi^T, then P is no longer referred.
+    for(unsigned int j(0); j < n; ++j){
+      for(unsigned int i(0); i < n; ++i){P_res(i, j) = 0;}
+      for(unsigned int k(0); k < n; ++k){
+        if(Phi(j, k) == 0){continue;}
+        for(unsigned int i(0); i < n; ++i){
+          P_res(i, j) += Phi_P(i, k) * Phi(j, k);
+        }
+      }
+    }
+
+    // P_res += Gamma_Q * Gamma^T, whose product is stored in Phi_P temporarily.
+    for(unsigned int j(0); j < n; ++j){
+      for(unsigned int i(0); i < n; ++i){Phi_P(i, j) = 0;}
+      for(unsigned int k(0); k < q; ++k){
+        if(Gamma(j, k) == 0){continue;}
+        for(unsigned int i(0); i < n; ++i){
+          Phi_P(i, j) += Gamma_Q(i, k) * Gamma(j, k);
+        }
+      }
+    }
+    for(unsigned int i(0); i < n; ++i){
+      for(unsigned int j(0); j < n; ++j){
+        P_res(i, j) += Phi_P(i, j);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Measurement update processing observations one by one
+ *
+ * When the observation error covariance matrix @f$ R @f$ is diagonal,
+ * each observation can be processed sequentially as a scalar one, i.e.,
+ * @f{gather*}
+ *   k_{i} = P H_{i}^{T} / (H_{i} P H_{i}^{T} + R_{ii}), \\
+ *   P \leftarrow P - k_{i} (P H_{i}^{T})^{T},
+ * @f}
+ * where @f$ H_{i} @f$ is the i-th row of @f$ H @f$.
+ * No matrix inversion is required.
+ * In addition, the Kalman gain @f$ K @f$ equivalent to the batch update,
+ * which satisfies @f$ \hat{x} = K z @f$, is accumulated as
+ * @f$ K \leftarrow K - k_{i} (H_{i} K) @f$ followed by replacing its i-th column with @f$ k_{i} @f$.
+ */
+struct KalmanFilter_SequentialCorrector {
+  /**
+   * @param P @f$ P @f$ (n * n), which is updated
+   * @param H @f$ H @f$ (m * n)
+   * @param R @f$ R @f$ (m * m), whose off-diagonal elements are ignored
+   * @param K buffer for Kalman gain (n * m), which must be cleared with zero
+   * @param P_Ht working buffer (n * 1)
+   */
+  template <
+      class MatrixT_P, class MatrixT_H, class MatrixT_R,
+      class MatrixT_K, class MatrixT_P_Ht>
+  static void correct(
+      MatrixT_P &P, const MatrixT_H &H, const MatrixT_R &R,
+      MatrixT_K &K, MatrixT_P_Ht &P_Ht){
+
+    const unsigned int n(P.rows()), m(H.rows());
+
+    for(unsigned int i(0); i < m; ++i){
+      // P_Ht = P * H_i^T, and S = H_i * P * H_i^T + R_ii
+      for(unsigned int j(0); j < n; ++j){P_Ht(j, 0) = 0;}
+      for(unsigned int k(0); k < n; ++k){
+        if(H(i, k) == 0){continue;}
+        for(unsigned int j(0); j < n; ++j){
+          P_Ht(j, 0) += P(j, k) * H(i, k);
+        }
+      }
+      typename MatrixT_P::storage_t::content_t S(R(i, i));
+      for(unsigned int k(0); k < n; ++k){
+        if(H(i, k) == 0){continue;}
+        S += H(i, k) * P_Ht(k, 0);
+      }
+
+      // K = K - k_i * (H_i * K), and K(:, i) = k_i
+      for(unsigned int l(0); l < i; ++l){
+        typename MatrixT_P::storage_t::content_t H_K(0);
+        for(unsigned int k(0); k < n; ++k){
+          if(H(i, k) == 0){continue;}
+          H_K += H(i, k) * K(k, l);
+        }
+        if(H_K == 0){continue;}
+        H_K /= S;
+        for(unsigned int j(0); j < n; ++j){
+          K(j, l) -= P_Ht(j, 0) * H_K;
+        }
+      }
+      for(unsigned int j(0); j < n; ++j){
+        K(j, i) = P_Ht(j, 0) / S;
+      }
+
+      // P = P - k_i * P_Ht^T
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int k(0); k < n; ++k){
+          P(j, k) -= K(j, i) * P_Ht(k, 0);
+        }
+      }
+    }
+  }
+};
+
 /** @file
  * @brief Kalman FilterLqt@CłB
  * 
@@ -129,7 +289,10 @@ class KalmanFilter{
       std::cerr << "Gamma:" << Gamma << std::endl;
 #endif
 
-      (m_P = Phi * m_P * Phi.transpose()) += (Gamma * m_Q * Gamma.transpose());
+      Matrix<FloatT> P(m_P.rows(), m_P.columns()),
+          Phi_P(Phi.rows(), m_P.columns()), Gamma_Q(Gamma.rows(), m_Q.columns());
+      KalmanFilter_SparsePredictor::predict(P, m_P, Phi, Gamma, m_Q, Phi_P, Gamma_Q);
+      m_P = P;
     }
     
     /**
@@ -163,11 +326,21 @@ class KalmanFilter{
      * @param H @f$ H @f$s(ϑs)
      * @param R ϑľ덷Us@f$ R @f$
      * @return (Matrix<FloatT>) J}QC@f$ K @f$
+     *
+     * RΊps̏ꍇAtspϑl1܂(KalmanFilter_SequentialCorrector)B
      */
     virtual Matrix<FloatT> correct(const Matrix<FloatT> &H, const Matrix<FloatT> &R){
 
+      if(R.isDiagonal()){
+        Matrix<FloatT> P(m_P.copy()), K(H.columns(), H.rows()), P_Ht(m_P.rows(), 1);
+        KalmanFilter_SequentialCorrector::correct(P, H, R, K, P_Ht);
+        m_P = P;
+        return K;
+      }
       // J}QČvZ
-      Matrix<FloatT> K(m_P * H.transpose() * ((H * m_P * H.transpose()) + R).inverse());
+      // K = P H^T S^{-1}, which is solved as S K^T = H P due to symmetric P and S
+      Matrix<FloatT> H_P(H * m_P);
+      Matrix<FloatT> K(((H_P * H.transpose()) + R).solve_spd(H_P).transpose().copy());
 #if DEBUG > 1
       std::cerr << "K:" << K << std::endl;
 #endif
@@ -315,10 +488,10 @@ class InformationFilter : public KalmanFilter<FloatT>{
 
       Matrix<FloatT> inv_additive_term(
           (Gamma * KalmanFilter<FloatT>::m_Q * Gamma.transpose()).inverse());
+      Matrix<FloatT> Phit_W(Phi.transpose() * inv_additive_term);
       m_I = inv_additive_term
-          - inv_additive_term * Phi 
-            * (m_I + Phi.transpose() * inv_additive_term * Phi).inverse()
-            * Phi.transpose() * inv_additive_term;
+          - Phit_W.transpose()
+            * (m_I + Phit_W * Phi).solve_spd(Phit_W);
 
       //sP̍XV
       need_update_P = true;
@@ -342,13 +515,12 @@ class InformationFilter : public KalmanFilter<FloatT>{
       std::cerr << "correct_KF_P:" << KalmanFilter<FloatT>::m_P << std::endl;
 #endif
       
-      Matrix<FloatT> R_inv(R.inverse());
-      Matrix<FloatT> H_trans(H.transpose());
+      Matrix<FloatT> Ht_R_inv(R.solve_spd(H).transpose().copy()); // H^T R^{-1}
       
-      m_I += H_trans * R_inv * H;
+      m_I += Ht_R_inv * H;
       
       // J}QC
-      Matrix<FloatT> K(m_I.inverse() * H_trans * R_inv);
+      Matrix<FloatT> K(m_I.solve_spd(Ht_R_inv));
       
       //sP̍XV
       need_update_P = true;
@@ -431,6 +603,7 @@ class KalmanFilterUD : public KalmanFilter<FloatT>{
           m_U(i, j) = UD(i, j);
         }
       }
+      need_update_P = true; // getP() returns P reconstructed from U and D
 #if DEBUG
       std::cerr << "U:" << m_U << std::endl;
       std::cerr << "D:" << m_D << std::endl;
@@ -895,7 +1068,7 @@ class UnscentedKalmanFilter : public KalmanFilter<FloatT>{
       P_yy += R;
       
       // J}QC
-      Matrix<FloatT> K(P_xy * P_yy.inverse());
+      Matrix<FloatT> K(P_yy.solve_spd(P_xy.transpose()).transpose().copy());
       
       // ԗ, P̏C
       Matrix<FloatT> delta_z(n_y, 1);
@@ -916,4 +1089,23 @@ class UnscentedKalmanFilter : public KalmanFilter<FloatT>{
     }
 };
 
+/**
+ * Selector of Kalman filter implementation corresponding to sizes of matrices,
+ * which are known at compile time by its user, for example, Filtered_INS2.
+ * By default, the specified filter, which utilizes (flexible size) Matrix, is used as it is.
+ *
+ * @param FilterT filter
+ * @param P_SIZE size of system error covariance matrix @f$ P @f$
+ * @param Q_SIZE size of input error covariance matrix @f$ Q @f$
+ */
+template <class FilterT, int P_SIZE, int Q_SIZE>
+struct KalmanFilter_Builder;
+
+template <template <class> class FilterT, class FloatT, int P_SIZE, int Q_SIZE>
+struct KalmanFilter_Builder<FilterT<FloatT>, P_SIZE, Q_SIZE> {
+  typedef FilterT<FloatT> filter_t;
+  typedef Matrix<FloatT> mat_A_t; ///< type for matrices A and Phi
+  typedef Matrix<FloatT> mat_B_t; ///< type for matrices B and Gamma
+};
+
 #endif /* __KALMAN_H__ */
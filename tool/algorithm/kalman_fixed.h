@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2016, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __KALMAN_FIXED_H__
+#define __KALMAN_FIXED_H__
+
+/** @file
+ * @brief extension of Kalman filter to use fixed size matrix
+ *
+ * Being different from the original filters,
+ * whose matrices are (flexible size) Matrix allocated in heap memory,
+ * the filter in this file utilizes Matrix_Fixed for P, Q, and time update matrices,
+ * whose sizes are determined at compile time.
+ * Therefore, time update does not require heap memory allocation.
+ *
+ * To use the filter with Filtered_INS2, specify KalmanFilterFixed as its filter,
+ * then its sizes are automatically resolved by KalmanFilter_Builder.
+ *
+ * @see kalman.h
+ * @see matrix_fixed.h
+ */
+
+#include "algorithm/kalman.h"
+#include "param/matrix_fixed.h"
+
+/**
+ * @brief Standard Kalman filter with fixed size matrices
+ *
+ * @param FloatT precision
+ * @param P_SIZE size of system error covariance matrix @f$ P @f$
+ * @param Q_SIZE size of input error covariance matrix @f$ Q @f$
+ */
+template <class FloatT, int P_SIZE, int Q_SIZE>
+class KalmanFilter_Fixed {
+  public:
+    typedef Matrix_Fixed<FloatT, P_SIZE> mat_P_t; ///< type for P, A, and Phi
+    typedef Matrix_Fixed<FloatT, Q_SIZE> mat_Q_t; ///< type for Q
+    typedef Matrix_Fixed<FloatT, P_SIZE, Q_SIZE> mat_PQ_t; ///< type for B and Gamma
+
+  protected:
+    mat_P_t m_P; ///< system error covariance matrix
+    mat_Q_t m_Q; ///< input error covariance matrix
+
+  public:
+    /**
+     * Constructor
+     *
+     * @param P @f$ P @f$ matrix, whose size must be P_SIZE
+     * @param Q @f$ Q @f$ matrix, whose size must be Q_SIZE
+     */
+    template <
+        class T_P, class Array2D_Type_P, class ViewType_P,
+        class T_Q, class Array2D_Type_Q, class ViewType_Q>
+    KalmanFilter_Fixed(
+        const Matrix_Frozen<T_P, Array2D_Type_P, ViewType_P> &P,
+        const Matrix_Frozen<T_Q, Array2D_Type_Q, ViewType_Q> &Q)
+        : m_P(P), m_Q(Q) {}
+
+    /**
+     * Copy constructor, which always performs deep copy.
+     *
+     * @param orig original
+     * @param deepcopy ignored
+     */
+    KalmanFilter_Fixed(const KalmanFilter_Fixed &orig, const bool &deepcopy = false)
+        : m_P(orig.m_P), m_Q(orig.m_Q) {}
+
+    virtual ~KalmanFilter_Fixed(){}
+
+    /**
+     * Time update with discrete system matrices
+     * @f[
+     *   x_{k+1} = \Phi_{k+1,K} * x_{k} + \Gamma_{k} * u_{k}
+     * @f]
+     *
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Gamma @f$ \Gamma @f$ matrix
+     */
+    void predict(const mat_P_t &Phi, const mat_PQ_t &Gamma){
+      mat_P_t Phi_P(P_SIZE, P_SIZE);
+      mat_PQ_t Gamma_Q(P_SIZE, Q_SIZE);
+      KalmanFilter_SparsePredictor::predict(m_P, m_P, Phi, Gamma, m_Q, Phi_P, Gamma_Q);
+    }
+
+    /**
+     * Time update with continuous system matrices by Euler method
+     * @f{gather*}
+     *   \frac{d}{dt} x = A x + B u \\
+     *   \Phi_{k+1,k} = I + A \Delta t \\
+     *   \Gamma_{k} = B \Delta t
+     * @f}
+     *
+     * @param A @f$ A @f$ matrix
+     * @param B @f$ B @f$ matrix
+     * @param delta time interval
+     */
+    void predict(const mat_P_t &A, const mat_PQ_t &B, const FloatT &delta){
+      mat_P_t Phi(A * delta);
+      for(unsigned int i(0); i < P_SIZE; ++i){Phi(i, i) += 1;}
+      predict(Phi, mat_PQ_t(B * delta));
+    }
+
+    /**
+     * Measurement update, whose number of observation is determined at compile time.
+     * When R is diagonal, KalmanFilter_SequentialCorrector is used without matrix inversion.
+     *
+     * @param H @f$ H @f$ matrix
+     * @param R observation error covariance matrix @f$ R @f$
+     * @return (Matrix_Fixed) Kalman gain @f$ K @f$
+     */
+    template <int Z_SIZE>
+    Matrix_Fixed<FloatT, P_SIZE, Z_SIZE> correct(
+        const Matrix_Fixed<FloatT, Z_SIZE, P_SIZE> &H,
+        const Matrix_Fixed<FloatT, Z_SIZE> &R){
+      if(R.isDiagonal()){
+        Matrix_Fixed<FloatT, P_SIZE, Z_SIZE> K(P_SIZE, Z_SIZE);
+        Matrix_Fixed<FloatT, P_SIZE, 1> P_Ht(P_SIZE, 1);
+        KalmanFilter_SequentialCorrector::correct(m_P, H, R, K, P_Ht);
+        return K;
+      }
+      Matrix_Fixed<FloatT, P_SIZE, Z_SIZE> P_Ht(m_P * H.transpose());
+      Matrix_Fixed<FloatT, Z_SIZE> S(H * P_Ht);
+      S += R;
+      Matrix_Fixed<FloatT, P_SIZE, Z_SIZE> K(S.solve_spd(P_Ht.transpose()).transpose().copy()); // P_Ht S^{-1}
+      mat_P_t I_KH(K * H * -1);
+      for(unsigned int i(0); i < P_SIZE; ++i){I_KH(i, i) += 1;}
+      m_P = I_KH * m_P;
+      return K;
+    }
+
+    /**
+     * Measurement update, whose number of observation is variable.
+     * When R is diagonal, KalmanFilter_SequentialCorrector is used without matrix inversion.
+     *
+     * @param H @f$ H @f$ matrix
+     * @param R observation error covariance matrix @f$ R @f$
+     * @return (Matrix<FloatT>) Kalman gain @f$ K @f$
+     */
+    Matrix<FloatT> correct(const Matrix<FloatT> &H, const Matrix<FloatT> &R){
+      if(R.isDiagonal()){
+        Matrix<FloatT> K(P_SIZE, H.rows());
+        mat_P_t P_Ht(P_SIZE, 1);
+        KalmanFilter_SequentialCorrector::correct(m_P, H, R, K, P_Ht);
+        return K;
+      }
+      Matrix<FloatT> P(m_P), H_P(H * P);
+      Matrix<FloatT> K(((H_P * H.transpose()) + R).solve_spd(H_P).transpose().copy()); // P H^T S^{-1}
+      m_P = (Matrix<FloatT>::getI(P_SIZE) - K * H) * P;
+      return K;
+    }
+
+    /**
+     * Return system error covariance matrix @f$ P @f$.
+     *
+     * @return (const mat_P_t &) @f$ P @f$
+     */
+    const mat_P_t &getP() const {return m_P;}
+
+    /**
+     * Set system error covariance matrix @f$ P @f$.
+     *
+     * @param P new @f$ P @f$
+     */
+    template <class T2, class Array2D_Type2, class ViewType2>
+    void setP(const Matrix_Frozen<T2, Array2D_Type2, ViewType2> &P){m_P = mat_P_t(P);}
+
+    /**
+     * Return input error covariance matrix @f$ Q @f$.
+     *
+     * @return (const mat_Q_t &) @f$ Q @f$
+     */
+    const mat_Q_t &getQ() const {return m_Q;}
+
+    /**
+     * Set input error covariance matrix @f$ Q @f$.
+     *
+     * @param Q new @f$ Q @f$
+     */
+    template <class T2, class Array2D_Type2, class ViewType2>
+    void setQ(const Matrix_Frozen<T2, Array2D_Type2, ViewType2> &Q){m_Q = mat_Q_t(Q);}
+};
+
+/**
+ * @brief Placeholder to select KalmanFilter_Fixed,
+ * which can be used as a filter template argument of Filtered_INS2.
+ *
+ * @param FloatT precision
+ */
+template <class FloatT>
+class KalmanFilterFixed;
+
+template <class FloatT, int P_SIZE, int Q_SIZE>
+struct KalmanFilter_Builder<KalmanFilterFixed<FloatT>, P_SIZE, Q_SIZE> {
+  typedef KalmanFilter_Fixed<FloatT, P_SIZE, Q_SIZE> filter_t;
+  typedef typename filter_t::mat_P_t mat_A_t;
+  typedef typename filter_t::mat_PQ_t mat_B_t;
+};
+
+#endif /* __KALMAN_FIXED_H__ */
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2016, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __KALMAN_SYMMETRIC_H__
+#define __KALMAN_SYMMETRIC_H__
+
+/** @file
+ * @brief extension of Kalman filter to store covariance matrices as symmetric ones
+ *
+ * The filters in this file store the system error covariance matrix @f$ P @f$ and
+ * the input error covariance matrix @f$ Q @f$ with Array2D_SymmetricPacked,
+ * which holds only their upper triangle elements.
+ * Time and measurement updates calculate only the unique (upper triangle) elements of @f$ P @f$,
+ * therefore its symmetry is always guaranteed, and memory traffic and multiplications
+ * required for the updates are approximately halved.
+ *
+ * To use the filters with Filtered_INS2, specify KalmanFilterSymmetric,
+ * or KalmanFilterJoseph which adopts Joseph form in measurement update, as its filter.
+ *
+ * @see kalman.h
+ * @see matrix_special.h
+ */
+
+#include "algorithm/kalman.h"
+#include "param/matrix_special.h"
+
+/**
+ * @brief Standard Kalman filter with symmetric covariance matrices
+ *
+ * @param FloatT precision
+ * @param use_joseph If true, measurement update is performed in Joseph form
+ * @f$ P \leftarrow (I - K H) P (I - K H)^{T} + K R K^{T} @f$, which is numerically robust
+ * against round-off errors. Otherwise, @f$ P \leftarrow P - K (P H^{T})^{T} @f$ is used.
+ */
+template <class FloatT, bool use_joseph = false>
+class KalmanFilter_Symmetric {
+  public:
+    typedef Matrix<FloatT> mat_t;
+    typedef Matrix<FloatT, Array2D_SymmetricPacked<FloatT> > mat_sym_t;
+
+  protected:
+    mat_sym_t m_P; ///< system error covariance matrix
+    mat_sym_t m_Q; ///< input error covariance matrix
+
+  public:
+    /**
+     * Constructor, where only the upper triangles of P and Q are used.
+     *
+     * @param P @f$ P @f$ matrix
+     * @param Q @f$ Q @f$ matrix
+     */
+    KalmanFilter_Symmetric(const mat_t &P, const mat_t &Q)
+        : m_P(P), m_Q(Q) {}
+
+    /**
+     * Copy constructor
+     *
+     * @param orig original
+     * @param deepcopy If true, deep copy is performed
+     */
+    KalmanFilter_Symmetric(const KalmanFilter_Symmetric &orig, const bool &deepcopy = false)
+        : m_P(orig.m_P), m_Q(orig.m_Q) {
+      if(deepcopy){
+        m_P = mat_sym_t(orig.m_P.copy());
+        m_Q = mat_sym_t(orig.m_Q.copy());
+      }
+    }
+
+    virtual ~KalmanFilter_Symmetric(){}
+
+    /**
+     * Time update with discrete system matrices
+     * @f[
+     *   x_{k+1} = \Phi_{k+1,K} * x_{k} + \Gamma_{k} * u_{k}
+     * @f]
+     * Multiplications by zero elements of @f$ \Phi @f$ and @f$ \Gamma @f$ are skipped
+     * as well as KalmanFilter_SparsePredictor.
+     *
+     * @param Phi @f$ \Phi @f$ matrix
+     * @param Gamma @f$ \Gamma @f$ matrix
+     */
+    void predict(const mat_t &Phi, const mat_t &Gamma){
+      const unsigned int n(Phi.rows()), q(Gamma.columns());
+
+      // Phi_P = Phi * P
+      mat_t Phi_P(n, n);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int k(0); k < n; ++k){
+          if(Phi(i, k) == 0){continue;}
+          for(unsigned int j(0); j < n; ++j){
+            Phi_P(i, j) += Phi(i, k) * m_P(k, j);
+          }
+        }
+      }
+
+      // Gamma_Q = Gamma * Q
+      mat_t Gamma_Q(n, q);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int k(0); k < q; ++k){
+          if(Gamma(i, k) == 0){continue;}
+          for(unsigned int j(0); j < q; ++j){
+            if(m_Q(k, j) == 0){continue;}
+            Gamma_Q(i, j) += Gamma(i, k) * m_Q(k, j);
+          }
+        }
+      }
+
+      // P = Phi_P * Phi^T + Gamma_Q * Gamma^T, whose upper triangle (i <= j) is calculated.
+      mat_sym_t P(n, n);
+      mat_t GQG(n, 1);
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int k(0); k < n; ++k){
+          if(Phi(j, k) == 0){continue;}
+          for(unsigned int i(0); i <= j; ++i){
+            P(i, j) += Phi_P(i, k) * Phi(j, k);
+          }
+        }
+        for(unsigned int i(0); i <= j; ++i){GQG(i, 0) = 0;}
+        for(unsigned int k(0); k < q; ++k){
+          if(Gamma(j, k) == 0){continue;}
+          for(unsigned int i(0); i <= j; ++i){
+            GQG(i, 0) += Gamma_Q(i, k) * Gamma(j, k);
+          }
+        }
+        for(unsigned int i(0); i <= j; ++i){P(i, j) += GQG(i, 0);}
+      }
+      m_P = P;
+    }
+
+    /**
+     * Time update with continuous system matrices by Euler method
+     * @f{gather*}
+     *   \frac{d}{dt} x = A x + B u \\
+     *   \Phi_{k+1,k} = I + A \Delta t \\
+     *   \Gamma_{k} = B \Delta t
+     * @f}
+     *
+     * @param A @f$ A @f$ matrix
+     * @param B @f$ B @f$ matrix
+     * @param delta time interval
+     */
+    void predict(const mat_t &A, const mat_t &B, const FloatT &delta){
+      mat_t Phi(A * delta);
+      for(unsigned int i(0); i < Phi.rows(); ++i){Phi(i, i) += 1;}
+      predict(Phi, mat_t(B * delta));
+    }
+
+    /**
+     * Measurement update
+     *
+     * @param H @f$ H @f$ matrix
+     * @param R observation error covariance matrix @f$ R @f$
+     * @return (mat_t) Kalman gain @f$ K @f$
+     */
+    mat_t correct(const mat_t &H, const mat_t &R){
+      const unsigned int n(m_P.rows()), z(H.rows());
+      mat_t P_Ht(m_P * H.transpose());
+      mat_t K(((H * P_Ht) + R).solve_spd(P_Ht.transpose()).transpose().copy()); // P_Ht S^{-1}
+
+      if(!use_joseph){
+        // P = P - K * P_Ht^T, whose upper triangle (i <= j) is calculated.
+        mat_sym_t P(n, n);
+        for(unsigned int i(0); i < n; ++i){
+          for(unsigned int j(i); j < n; ++j){
+            FloatT sum(m_P(i, j));
+            for(unsigned int k(0); k < z; ++k){
+              sum -= K(i, k) * P_Ht(j, k);
+            }
+            P(i, j) = sum;
+          }
+        }
+        m_P = P;
+        return K;
+      }
+
+      // P = (I - K H) P (I - K H)^T + K R K^T, whose upper triangle (i <= j) is calculated.
+      mat_t I_KH(K * H * -1);
+      for(unsigned int i(0); i < n; ++i){I_KH(i, i) += 1;}
+      mat_t I_KH_P(I_KH * m_P), K_R(K * R);
+      mat_sym_t P(n, n);
+      for(unsigned int i(0); i < n; ++i){
+        for(unsigned int j(i); j < n; ++j){
+          FloatT sum(0);
+          for(unsigned int k(0); k < n; ++k){
+            sum += I_KH_P(i, k) * I_KH(j, k);
+          }
+          for(unsigned int k(0); k < z; ++k){
+            sum += K_R(i, k) * K(j, k);
+          }
+          P(i, j) = sum;
+        }
+      }
+      m_P = P;
+      return K;
+    }
+
+    /**
+     * Return system error covariance matrix @f$ P @f$ as a (dense) matrix.
+     *
+     * @return (mat_t) @f$ P @f$
+     */
+    mat_t getP() const {return m_P.copy();}
+
+    /**
+     * Return system error covariance matrix @f$ P @f$ in packed storage.
+     *
+     * @return (const mat_sym_t &) @f$ P @f$
+     */
+    const mat_sym_t &getP_symmetric() const {return m_P;}
+
+    /**
+     * Set system error covariance matrix @f$ P @f$, whose upper triangle is used.
+     *
+     * @param P new @f$ P @f$
+     */
+    void setP(const mat_t &P){m_P = mat_sym_t(P);}
+
+    /**
+     * Return input error covariance matrix @f$ Q @f$ as a (dense) matrix.
+     *
+     * @return (mat_t) @f$ Q @f$
+     */
+    mat_t getQ() const {return m_Q.copy();}
+
+    /**
+     * Set input error covariance matrix @f$ Q @f$, whose upper triangle is used.
+     *
+     * @param Q new @f$ Q @f$
+     */
+    void setQ(const mat_t &Q){m_Q = mat_sym_t(Q);}
+};
+
+/**
+ * @brief Kalman filter with symmetric covariance matrices,
+ * which can be used as a filter template argument of Filtered_INS2.
+ *
+ * @param FloatT precision
+ */
+template <class FloatT>
+class KalmanFilterSymmetric : public KalmanFilter_Symmetric<FloatT, false> {
+  public:
+    typedef KalmanFilter_Symmetric<FloatT, false> super_t;
+    KalmanFilterSymmetric(const typename super_t::mat_t &P, const typename super_t::mat_t &Q)
+        : super_t(P, Q) {}
+    KalmanFilterSymmetric(const KalmanFilterSymmetric &orig, const bool &deepcopy = false)
+        : super_t(orig, deepcopy) {}
+};
+
+/**
+ * @brief Kalman filter with symmetric covariance matrices and Joseph form measurement update,
+ * which can be used as a filter template argument of Filtered_INS2.
+ *
+ * @param FloatT precision
+ */
+template <class FloatT>
+class KalmanFilterJoseph : public KalmanFilter_Symmetric<FloatT, true> {
+  public:
+    typedef KalmanFilter_Symmetric<FloatT, true> super_t;
+    KalmanFilterJoseph(const typename super_t::mat_t &P, const typename super_t::mat_t &Q)
+        : super_t(P, Q) {}
+    KalmanFilterJoseph(const KalmanFilterJoseph &orig, const bool &deepcopy = false)
+        : super_t(orig, deepcopy) {}
+};
+
+#endif /* __KALMAN_SYMMETRIC_H__ */
@@ -51,7 +51,11 @@
 
 #include "util/comstream.h"
 #include "util/nullstream.h"
+#include "util/mapped_file.h"
 #include "util/endian.h"
+#include "util/num_format.h"
+
+#include "SylphideLogIndex.h"
 
 /**
  * Convert units from degrees to radians
@@ -123,8 +127,12 @@ struct GlobalOptions {
   std::ostream *_out_debug; ///< Pointer for debug output stream
   bool in_sylphide;   ///< True when inputs is Sylphide formated
   bool out_sylphide;  ///< True when outputs is Sylphide formated
+  bool use_mmap;      ///< True when log files are read through memory mapping
+  bool use_index;     ///< True when sidecar indices of mapped logs are used to skip pages out of time range
   typedef std::map<const char *, std::iostream *> iostream_pool_t;
   iostream_pool_t iostream_pool;
+  typedef std::map<const char *, MappedFile *> mapped_pool_t;
+  mapped_pool_t mapped_pool;
 
   static const char *null_fname(){
 #if defined(_MSC_VER)
@@ -141,7 +149,11 @@ struct GlobalOptions {
       _out(&(std::cout)),
       _out_debug(&blackhole),
       in_sylphide(false), out_sylphide(false),
-      iostream_pool() {};
+      use_mmap(true), use_index(true),
+      iostream_pool(), mapped_pool() {
+    std::ios::sync_with_stdio(false); // std::cout is buffered by itself
+    FastNumPut<>::imbue(std::cout);
+  };
   virtual ~GlobalOptions(){
     for(iostream_pool_t::iterator it(iostream_pool.begin());
         it != iostream_pool.end();
@@ -149,6 +161,11 @@ struct GlobalOptions {
       it->second->flush();
       delete it->second;
     }
+    for(mapped_pool_t::iterator it(mapped_pool.begin());
+        it != mapped_pool.end();
+        ++it){
+      delete it->second;
+    }
   }
   
   template <class T1, class T2>
@@ -203,6 +220,9 @@ struct GlobalOptions {
         if(iostream_pool.find(spec) == iostream_pool.end()){
           ComportStream *com_in = new ComportStream(spec);
           if(baudrate_spec){set_baudrate(*com_in, baudrate_spec);}
+#if defined(COMSTREAM_USE_THREAD)
+          com_in->buffer().start_reader();
+#endif
           iostream_pool[spec] = com_in;
           return *com_in;
         }else{
@@ -222,6 +242,77 @@ struct GlobalOptions {
     return *fin;
   }
   
+  /**
+   * Map a log file to memory, which enables page processing without copy.
+   *
+   * @param spec file name
+   * @return (const MappedFile *) mapped file, or NULL when the spec is not
+   * a regular file such as standard input and COM ports,
+   * or memory mapping is deactivated.
+   */
+  const MappedFile *spec2mapped(const char *spec){
+    if((!use_mmap) || (std::strcmp(spec, "-") == 0)
+        || (!MappedFile::is_mappable(spec))){
+      return NULL;
+    }
+    std::cerr << spec;
+    MappedFile *mapped;
+    try{
+      mapped = new MappedFile(spec);
+    }catch(std::ios_base::failure &e){
+      std::cerr << " => " << e.what() << std::endl;
+      return NULL;
+    }
+    std::cerr << " [mmap]" << std::endl;
+    mapped_pool[spec] = mapped;
+    return mapped;
+  }
+
+  /**
+   * Pages of a mapped log, which are restricted to the time range
+   * when the sidecar index of the log (generated by log_index) is available.
+   *
+   * @param spec file name of the log
+   * @param mapped mapped log
+   * @return (MappedFile::page_reader_t) pages to be processed
+   */
+  MappedFile::page_reader_t spec2pages(const char *spec, const MappedFile &mapped){
+    MappedFile::page_reader_t res(mapped.pages(SYLPHIDE_PAGE_SIZE));
+    if(!use_index){return res;}
+    std::string fname(SylphideLogIndex::index_fname(spec));
+    if(!MappedFile::is_mappable(fname.c_str())){return res;}
+    std::cerr << fname;
+    SylphideLogIndex index;
+    {
+      std::ifstream in(fname.c_str(), std::ios::in | std::ios::binary);
+      if((!index.load(in))
+          || (index.header.pages != (mapped.size() / SYLPHIDE_PAGE_SIZE))){
+        std::cerr << " => Invalid or outdated index, ignored" << std::endl;
+        return res;
+      }
+    }
+    unsigned int start(index.start_page(*this)), end(index.end_page(*this));
+    if(end < start){end = start;}
+    res.current += (std::size_t)SYLPHIDE_PAGE_SIZE * start;
+    res.end = res.current + (std::size_t)SYLPHIDE_PAGE_SIZE * (end - start);
+    std::cerr << " [index] pages " << start << "-" << end
+        << " of " << index.header.pages << std::endl;
+    return res;
+  }
+
+  /**
+   * File stream having a larger buffer than the default (BUFSIZ)
+   * in order to write text output in big chunks.
+   */
+  struct buffered_fstream : public std::fstream {
+    char buf[0x10000];
+    buffered_fstream(const char *fname, std::ios::openmode mode) : std::fstream() {
+      rdbuf()->pubsetbuf(buf, sizeof(buf));
+      open(fname, mode);
+    }
+    ~buffered_fstream(){close();}
+  };
+
   std::ostream &spec2ostream(
       const char *spec,
       const bool &force_fstream = false){
@@ -245,6 +336,7 @@ struct GlobalOptions {
         if(iostream_pool.find(spec) == iostream_pool.end()){
           ComportStream *com_out = new ComportStream(spec);
           if(baudrate_spec){set_baudrate(*com_out, baudrate_spec);}
+          FastNumPut<>::imbue(*com_out);
           iostream_pool[spec] = com_out;
           return *com_out;
         }else{
@@ -254,7 +346,8 @@ struct GlobalOptions {
     }
     
     std::cerr << spec;
-    std::fstream *fout(new std::fstream(spec, std::ios::out | std::ios::binary));
+    std::fstream *fout(new buffered_fstream(spec, std::ios::out | std::ios::binary));
+    FastNumPut<>::imbue(*fout);
     std::cerr << std::endl;
     iostream_pool[spec] = fout;
     return *fout;
@@ -424,6 +517,9 @@ if(key_checked){ \
     CHECK_OPTION_BOOL(in_sylphide);
 
     CHECK_OPTION_BOOL(out_sylphide);
+
+    CHECK_OPTION_BOOL(use_mmap);
+    CHECK_OPTION_BOOL(use_index);
 #undef CHECK_OPTION_BOOL
 #undef CHECK_OPTION
     return false;
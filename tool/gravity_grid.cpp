@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2017, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Generate a gravity grid file for INS_GPS --egm_grid option.
+ *
+ * Usage: (exe) [options] out_file
+ *   --lat=min,max   geodetic latitude range [deg]
+ *   --lng=min,max   longitude range [deg]
+ *   --height=min,max height range [m], default -200,3000
+ *   --step_deg=x    horizontal interval [deg], default 0.01
+ *   --step_m=x      vertical interval [m], default 100
+ */
+
+#if defined(_MSC_VER) && _MSC_VER >= 1400
+#define _USE_MATH_DEFINES
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+#include "navigation/EGM_Grid.h"
+
+typedef EGM_Grid<EGM2008_70> grid_egm_t;
+
+static bool parse_range(const char *value, double (&range)[2]){
+  char *next;
+  range[0] = std::strtod(value, &next);
+  if((next == value) || (*next != ',')){return false;}
+  value = next + 1;
+  range[1] = std::strtod(value, &next);
+  return (next != value) && (range[0] < range[1]);
+}
+
+int main(int argc, char *argv[]){
+  double lat[2] = {0, 0}, lng[2] = {0, 0}, height[2] = {-200, 3000};
+  double step_deg(0.01), step_m(100);
+  const char *out_fname(NULL);
+
+  for(int i(1); i < argc; ++i){
+    const char *arg(argv[i]);
+    bool ok(true);
+    if(std::strncmp(arg, "--lat=", 6) == 0){
+      ok = parse_range(arg + 6, lat);
+    }else if(std::strncmp(arg, "--lng=", 6) == 0){
+      ok = parse_range(arg + 6, lng);
+    }else if(std::strncmp(arg, "--height=", 9) == 0){
+      ok = parse_range(arg + 9, height);
+    }else if(std::strncmp(arg, "--step_deg=", 11) == 0){
+      ok = ((step_deg = std::atof(arg + 11)) > 0);
+    }else if(std::strncmp(arg, "--step_m=", 9) == 0){
+      ok = ((step_m = std::atof(arg + 9)) > 0);
+    }else if(std::strncmp(arg, "--", 2) != 0){
+      out_fname = arg;
+    }else{
+      ok = false;
+    }
+    if(!ok){
+      std::cerr << "Invalid option: " << arg << std::endl;
+      return -1;
+    }
+  }
+  if((!out_fname) || !(lat[0] < lat[1]) || !(lng[0] < lng[1])){
+    std::cerr << "Usage: " << argv[0]
+        << " --lat=min,max --lng=min,max [--height=min,max] [--step_deg=x] [--step_m=x] out_file"
+        << std::endl;
+    return -1;
+  }
+
+  // Geodetic latitude is converted to geocentric one with a margin of one interval.
+  grid_egm_t::header_t spec;
+  {
+    double step(M_PI / 180 * step_deg);
+    double phi[2] = {
+      WGS84::geocentric_latitude(M_PI / 180 * lat[0]) - step,
+      WGS84::geocentric_latitude(M_PI / 180 * lat[1]) + step};
+    double lambda[2] = {M_PI / 180 * lng[0], M_PI / 180 * lng[1]};
+    spec.origin[0] = phi[0];
+    spec.origin[1] = lambda[0];
+    spec.origin[2] = height[0];
+    spec.step[0] = spec.step[1] = step;
+    spec.step[2] = step_m;
+    spec.num[0] = (int)std::ceil((phi[1] - phi[0]) / step) + 1;
+    spec.num[1] = (int)std::ceil((lambda[1] - lambda[0]) / step) + 1;
+    spec.num[2] = (int)std::ceil((height[1] - height[0]) / step_m) + 1;
+  }
+  std::cerr << "Nodes: "
+      << spec.num[0] << " x " << spec.num[1] << " x " << spec.num[2] << std::endl;
+
+  try{
+    grid_egm_t::grid_t grid(spec);
+    std::ofstream out(out_fname, std::ios::out | std::ios::binary);
+    if(!out){
+      std::cerr << "Could not open " << out_fname << std::endl;
+      return -1;
+    }
+    grid.save(out);
+    std::cerr << "Interpolation error (r, phi, lambda) [m/s^2]: "
+        << grid.header->max_error[0] << ", "
+        << grid.header->max_error[1] << ", "
+        << grid.header->max_error[2] << std::endl;
+  }catch(std::exception &e){
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
@@ -39,6 +39,8 @@ typedef __int64 int64_t;
 #include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <string>
+#include <list>
 #include <exception>
 
 #define IS_LITTLE_ENDIAN 1
@@ -48,6 +50,7 @@ typedef __int64 int64_t;
 typedef double float_sylph_t;
 #include "analyze_common.h"
 #include "calibration.h"
+#include "util/columnar.h"
 
 using namespace std;
 
@@ -70,6 +73,12 @@ struct Options : public GlobalOptions<float_sylph_t> {
   calendar_time_t::Converter time_gps2local;
   bool use_calendar_time;
   bool as_filter;
+  enum {
+    FORMAT_CSV,
+    FORMAT_COLUMNAR, ///< binary records per page type, see ColumnarWriter
+  } format;
+  std::string out_prefix; ///< prefix of columnar output files, whose default is the log file name
+  std::list<std::string> columnar_fnames; ///< names of columnar output files, which are keys of iostream_pool
 
   typedef StandardCalibration<float_sylph_t> inertial_conv_t;
 
@@ -85,7 +94,8 @@ struct Options : public GlobalOptions<float_sylph_t> {
       page_M_mode(0),
       debug_level(0),
       time_gps2local(),
-      use_calendar_time(false), as_filter(false) {
+      use_calendar_time(false), as_filter(false),
+      format(FORMAT_CSV), out_prefix(), columnar_fnames() {
 
     physical_converter.is_active = false;
     super_t::set_typical_calibration_specs(physical_converter.inertial_conv);
@@ -130,6 +140,19 @@ struct Options : public GlobalOptions<float_sylph_t> {
     return super_t::is_time_in_range(time_gps2local.gps_time.sec, time_gps2local.gps_time.wn);
   }
 
+  /**
+   * Start columnar output to (out_prefix).(page type).col
+   *
+   * @param writer writer whose columns have been defined
+   */
+  void start_columnar(ColumnarWriter &writer){
+    columnar_fnames.push_back(out_prefix);
+    std::string &fname(columnar_fnames.back());
+    fname.append(".").append(1, writer.page()).append(".col");
+    cerr << "columnar out: ";
+    writer.start(spec2ostream(fname.c_str(), true));
+  }
+
   /**
    * Check command argument
    * 
@@ -196,6 +219,18 @@ struct Options : public GlobalOptions<float_sylph_t> {
     CHECK_OPTION(debug, false,
         debug_level = atoi(value),
         debug_level);
+    CHECK_OPTION(format, false,
+        if(std::strcmp(value, "columnar") == 0){
+          format = FORMAT_COLUMNAR;
+        }else if(std::strcmp(value, "csv") == 0){
+          format = FORMAT_CSV;
+        }else{
+          return false;
+        },
+        value);
+    CHECK_OPTION(out_prefix, false,
+        out_prefix = value,
+        out_prefix);
     CHECK_OPTION(as_filter, true,
         as_filter = is_true(value),
         (as_filter ? "on" : "off"));
@@ -260,20 +295,24 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
         }
         options.out() << values.temperature << endl;
       }
-      void dump_physical(const float_sylph_t &current, const A_Observer_t::values_t &values) const {
-        options.out()
-            << count << ", "
-            << options.format_time(current);
-
+      static void convert(const A_Observer_t::values_t &values,
+          Options::inertial_conv_t::result_t &accel, Options::inertial_conv_t::result_t &omega){
         int ch[9];
         for(int i = 0; i < 8; i++){
           ch[i] = values.values[i];
         }
         ch[8] = values.temperature;
 
-        Options::inertial_conv_t::result_t
-            accel(options.physical_converter.inertial_conv.raw2accel(ch)),
-            omega(options.physical_converter.inertial_conv.raw2omega(ch));
+        accel = options.physical_converter.inertial_conv.raw2accel(ch);
+        omega = options.physical_converter.inertial_conv.raw2omega(ch);
+      }
+      void dump_physical(const float_sylph_t &current, const A_Observer_t::values_t &values) const {
+        options.out()
+            << count << ", "
+            << options.format_time(current);
+
+        Options::inertial_conv_t::result_t accel, omega;
+        convert(values, accel, omega);
 
         for(int i(0); i < 3; i++){ // accelerometer[m/s^2]
           options.out() << ", " << accel.values[i];
@@ -283,7 +322,39 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
         }
         options.out() << endl;
       }
-      HandlerA() : count(0), formatter(&HandlerA::dump_raw) {}
+      mutable ColumnarWriter columnar;
+      void dump_raw_columnar(const float_sylph_t &current, const A_Observer_t::values_t &values) const {
+        if(!columnar.is_started()){
+          static const char *names[] = {"ch0", "ch1", "ch2", "ch3", "ch4", "ch5", "ch6", "ch7"};
+          columnar.add("count", ColumnarWriter::UINT32).add("itow", ColumnarWriter::FLOAT64)
+              .add(names, ColumnarWriter::UINT32).add("temperature", ColumnarWriter::UINT32);
+          options.start_columnar(columnar);
+        }
+        columnar << count << current;
+        for(int i(0); i < 8; i++){
+          columnar << values.values[i];
+        }
+        columnar << values.temperature;
+      }
+      void dump_physical_columnar(const float_sylph_t &current, const A_Observer_t::values_t &values) const {
+        if(!columnar.is_started()){
+          static const char *names[] = { // [m/s^2], [deg/s]
+            "accel_x", "accel_y", "accel_z", "omega_x", "omega_y", "omega_z"};
+          columnar.add("count", ColumnarWriter::UINT32).add("itow", ColumnarWriter::FLOAT64)
+              .add(names, ColumnarWriter::FLOAT64);
+          options.start_columnar(columnar);
+        }
+        Options::inertial_conv_t::result_t accel, omega;
+        convert(values, accel, omega);
+        columnar << count << current;
+        for(int i(0); i < 3; i++){
+          columnar << accel.values[i];
+        }
+        for(int i(0); i < 3; i++){
+          columnar << rad2deg(omega.values[i]);
+        }
+      }
+      HandlerA() : count(0), formatter(&HandlerA::dump_raw), columnar('A') {}
     } handler_A;
     
     /**
@@ -297,10 +368,12 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
       super_t::G_Observer_t::position_acc_t position_acc;
       super_t::G_Observer_t::velocity_t velocity;
       super_t::G_Observer_t::velocity_acc_t velocity_acc;
+      ColumnarWriter columnar;
       HandlerG() 
           : itow_ms_0x0102(0), itow_ms_0x0112(0),
           position(0, 0, 0), position_acc(0, 0),
-          velocity(0, 0, 0), velocity_acc(0) {
+          velocity(0, 0, 0), velocity_acc(0),
+          columnar('G') {
       }
       ~HandlerG(){}
       
@@ -378,6 +451,27 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
           
           float_sylph_t current(1E-3 * itow_ms_0x0102);
           if(!options.is_time_in_range(current)){return;}
+
+          if(options.format == Options::FORMAT_COLUMNAR){
+            if(!columnar.is_started()){
+              static const char *names[] = {
+                "itow", "latitude", "longitude", "altitude", "acc_2d", "acc_v",
+                "v_north", "v_east", "v_down", "acc_vel"};
+              columnar.add(names, ColumnarWriter::FLOAT64);
+              options.start_columnar(columnar);
+            }
+            columnar << current
+                << position.latitude
+                << position.longitude
+                << position.altitude
+                << position_acc.horizontal
+                << position_acc.vertical
+                << velocity.north
+                << velocity.east
+                << velocity.down
+                << velocity_acc.acc;
+            return;
+          }
           
           options.out() << options.format_time(current) << ", "
               << position.latitude << ", "
@@ -400,12 +494,40 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
      */
     struct HandlerF {
       int count;
-      HandlerF() : count(0) {}
+      ColumnarWriter columnar;
+      HandlerF() : count(0), columnar('F') {}
+      void dump_columnar(const float_sylph_t &current, const F_Observer_t::values_t &values){
+        if(!columnar.is_started()){
+          columnar.add("count", ColumnarWriter::UINT32).add("itow", ColumnarWriter::FLOAT64);
+          for(int i = 0; i < 8; i++){
+            char name[16];
+            if(options.page_F_mode & 0x01){
+              std::sprintf(name, "servo_in%d", i);
+              columnar.add(name, ColumnarWriter::UINT32);
+            }
+            if(options.page_F_mode & 0x02){
+              std::sprintf(name, "servo_out%d", i);
+              columnar.add(name, ColumnarWriter::UINT32);
+            }
+          }
+          options.start_columnar(columnar);
+        }
+        columnar << (count++) << current;
+        for(int i = 0; i < 8; i++){
+          if(options.page_F_mode & 0x01){columnar << values.servo_in[i];}
+          if(options.page_F_mode & 0x02){columnar << values.servo_out[i];}
+        }
+      }
       void operator()(const F_Observer_t &observer){
         if(!observer.validate()){return;}
         
         float_sylph_t current(StreamProcessor::get_corrected_ITOW(observer));
         if(!options.is_time_in_range(current)){return;}
+
+        if(options.format == Options::FORMAT_COLUMNAR){
+          dump_columnar(current, observer.fetch_values());
+          return;
+        }
         
         options.out() << (count++)
              << ", " << options.format_time(current);
@@ -509,7 +631,28 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
             << (float_sylph_t)pressure << ", "  // [Pa]
             << (float_sylph_t)temperature / 100 << endl; // [degC]
       }
-      HandlerP() : formatter(&HandlerP::dump_raw) {}
+      mutable ColumnarWriter columnar;
+      void dump_raw_columnar(
+          const float_sylph_t &current, const int &index,
+          const Int32 &pressure, const Int32 &temperature) const {
+        if(!columnar.is_started()){
+          columnar.add("itow", ColumnarWriter::FLOAT64).add("index", ColumnarWriter::INT32)
+              .add("pressure", ColumnarWriter::INT32).add("temperature", ColumnarWriter::INT32);
+          options.start_columnar(columnar);
+        }
+        columnar << current << index << pressure << temperature;
+      }
+      void dump_physical_columnar(
+          const float_sylph_t &current, const int &index,
+          const Int32 &pressure, const Int32 &temperature) const {
+        if(!columnar.is_started()){ // [Pa], [degC]
+          columnar.add("itow", ColumnarWriter::FLOAT64).add("index", ColumnarWriter::INT32)
+              .add("pressure", ColumnarWriter::FLOAT64).add("temperature", ColumnarWriter::FLOAT64);
+          options.start_columnar(columnar);
+        }
+        columnar << current << index << (float_sylph_t)pressure << (float_sylph_t)temperature / 100;
+      }
+      HandlerP() : formatter(&HandlerP::dump_raw), columnar('P') {}
     } handler_P;
     
     /**
@@ -529,6 +672,18 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
 
         switch(options.page_M_mode){
           case 1: // -atan2(y, x)[deg]\
+            if(options.format == Options::FORMAT_COLUMNAR){
+              if(!columnar.is_started()){
+                columnar.add("itow", ColumnarWriter::FLOAT64).add("index", ColumnarWriter::INT32)
+                    .add("heading", ColumnarWriter::FLOAT64);
+                options.start_columnar(columnar);
+              }
+              for(int i(0), j(-3); i < 4; i++, j++){
+                columnar << current << j
+                    << rad2deg(-atan2((double)values.y[i], (double)values.x[i]));
+              }
+              break;
+            }
             for(int i(0), j(-3); i < 4; i++, j++){
               options.out() << options.format_time(current) << ", "
                    << j << ", "
@@ -556,7 +711,18 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
          */
         dump_raw(current, values);
       }
-      HandlerM() : formatter(&HandlerM::dump_raw) {}
+      mutable ColumnarWriter columnar;
+      void dump_raw_columnar(const float_sylph_t &current, const M_Observer_t::values_t &values) const {
+        if(!columnar.is_started()){
+          columnar.add("itow", ColumnarWriter::FLOAT64).add("index", ColumnarWriter::INT32)
+              .add("x", ColumnarWriter::INT32).add("y", ColumnarWriter::INT32).add("z", ColumnarWriter::INT32);
+          options.start_columnar(columnar);
+        }
+        for(int i(0), j(-3); i < 4; i++, j++){
+          columnar << current << j << values.x[i] << values.y[i] << values.z[i];
+        }
+      }
+      HandlerM() : formatter(&HandlerM::dump_raw), columnar('M') {}
     } handler_M;
     /**
     
@@ -565,6 +731,8 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
      * @param observer M page observer
      */
     struct HandlerN {
+      ColumnarWriter columnar;
+      HandlerN() : columnar('N') {}
       void operator()(const N_Observer_t &observer){
         if(!observer.validate()){return;}
         
@@ -574,6 +742,27 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
         switch(observer.kind()){
           case 0: {
             N_Observer_t::navdata_t values(observer.fetch_navdata());
+
+            if(options.format == Options::FORMAT_COLUMNAR){
+              if(!columnar.is_started()){
+                static const char *names[] = {
+                  "itow", "longitude", "latitude", "altitude",
+                  "v_north", "v_east", "v_down", "heading", "pitch", "roll"};
+                columnar.add(names, ColumnarWriter::FLOAT64);
+                options.start_columnar(columnar);
+              }
+              columnar << values.itow
+                  << values.longitude
+                  << values.latitude
+                  << values.altitude
+                  << values.v_north
+                  << values.v_east
+                  << values.v_down
+                  << values.heading
+                  << values.pitch
+                  << values.roll;
+              break;
+            }
             
             options.out() << options.format_time(values.itow) << ", "
                 << values.longitude << ", "
@@ -629,7 +818,7 @@ class StreamProcessor : public SylphideProcessor<float_sylph_t> {
     }
     ~StreamProcessor(){}
     
-    void process_pages(char *buf, const int &buf_size){
+    void process_pages(const char *buf, const int &buf_size){
       switch(buf[0]){
 #define assign_case_cnd(type, mark, cnd) \
 case mark: if(cnd){ \
@@ -673,7 +862,7 @@ break;
       }
     }
 
-    void filter_pages(char *buf, const int &buf_size){
+    void filter_pages(const char *buf, const int &buf_size){
       switch(buf[0]){
 #define filter_page(type, mark) \
 case mark: if(options.page_selected[Options::PAGE_ ## type] < Options::PAGE_SELECTED_DEFAULT){return;} break;
@@ -697,14 +886,14 @@ case mark: if(options.page_selected[Options::PAGE_ ## type] < Options::PAGE_SELE
       options.out().write(buf, buf_size);
     }
 
+    typedef void (StreamProcessor::*task_t)(const char *, const int &);
+
     /**
-     * Extract packet from stream until the end of stream is found
-     * 
-     * @param in stream
+     * Select page processing task according to options
+     *
+     * @return (task_t) task to be invoked for each page
      */
-    void process(istream &in){
-      char buffer[SYLPHIDE_PAGE_SIZE];
-      
+    task_t setup_task(){
       if(options.physical_converter.is_active){
         handler_A.formatter = &HandlerA::dump_physical;
         handler_P.formatter = &HandlerP::dump_physical;
@@ -713,16 +902,52 @@ case mark: if(options.page_selected[Options::PAGE_ ## type] < Options::PAGE_SELE
             "for acceleration, angular speed, pressure, and temperature, respectively."
             << endl;
       }
+      if(options.format == Options::FORMAT_COLUMNAR){
+        if(options.physical_converter.is_active){
+          handler_A.formatter = &HandlerA::dump_physical_columnar;
+          handler_P.formatter = &HandlerP::dump_physical_columnar;
+        }else{
+          handler_A.formatter = &HandlerA::dump_raw_columnar;
+          handler_P.formatter = &HandlerP::dump_raw_columnar;
+        }
+        handler_M.formatter = &HandlerM::dump_raw_columnar;
+      }
 
-      void (StreamProcessor::*task)(char *, const int &)(&StreamProcessor::process_pages);
       if(options.as_filter){
 #if defined(_MSC_VER) || defined(__CYGWIN__)
         if(&(options.out()) == &(std::cout)){
           setmode(fileno(stdout), O_BINARY); // change binary mode explicitly
         }
 #endif
-        task = &StreamProcessor::filter_pages;
+        return &StreamProcessor::filter_pages;
       }
+      return &StreamProcessor::process_pages;
+    }
+
+    void debug_page(const char *buffer, const int &read_count) const {
+      cerr << "--read-- : " << invoked << " page" << endl;
+      cerr << hex;
+      for(int i(0); i < read_count; i++){
+        cerr << setfill('0') 
+            << setw(2)
+            << (unsigned int)((unsigned char)buffer[i]) << ' ';
+      }
+      cerr << dec;
+      cerr << endl;
+
+      if(read_count < SYLPHIDE_PAGE_SIZE){
+        cerr << "--skipped-- : " << invoked << " page ; count = " << read_count << endl;
+      }
+    }
+
+    /**
+     * Extract packet from stream until the end of stream is found
+     * 
+     * @param in stream
+     */
+    void process(istream &in){
+      char buffer[SYLPHIDE_PAGE_SIZE];
+      task_t task(setup_task());
 
       int read_count;
       while(true){
@@ -731,25 +956,33 @@ case mark: if(options.page_selected[Options::PAGE_ ## type] < Options::PAGE_SELE
         if(in.fail() || (read_count == 0)){return;}
         invoked++;
       
-        if(options.debug_level){
-          cerr << "--read-- : " << invoked << " page" << endl;
-          cerr << hex;
-          for(int i(0); i < read_count; i++){
-            cerr << setfill('0') 
-                << setw(2)
-                << (unsigned int)((unsigned char)buffer[i]) << ' ';
-          }
-          cerr << dec;
-          cerr << endl;
-          
-          if(read_count < SYLPHIDE_PAGE_SIZE){
-            cerr << "--skipped-- : " << invoked << " page ; count = " << read_count << endl;
-          }
-        }
+        if(options.debug_level){debug_page(buffer, read_count);}
       
         (this->*task)(buffer, read_count);
       }
     }
+
+    /**
+     * Extract packet from memory mapped log.
+     * Pages are passed to observers without copy.
+     *
+     * @param pages pages of mapped log
+     */
+    void process(MappedFile::page_reader_t pages){
+      task_t task(setup_task());
+
+      const char *buffer;
+      int read_count;
+      while(true){
+        read_count = pages.next(buffer);
+        if(read_count < SYLPHIDE_PAGE_SIZE){return;} // the same as truncated stream
+        invoked++;
+
+        if(options.debug_level){debug_page(buffer, read_count);}
+
+        (this->*task)(buffer, read_count);
+      }
+    }
 };
 
 int main(int argc, char *argv[]){
@@ -788,9 +1021,12 @@ int main(int argc, char *argv[]){
   }
   
   options.out().precision(10);
+  if(options.out_prefix.empty()){options.out_prefix = argv[log_index];}
   if(options.in_sylphide){
     SylphideIStream sylph_in(options.spec2istream(argv[log_index]), SYLPHIDE_PAGE_SIZE);
     processor.process(sylph_in);
+  }else if(const MappedFile *mapped = options.spec2mapped(argv[log_index])){
+    processor.process(options.spec2pages(argv[log_index], *mapped));
   }else{
     processor.process(options.spec2istream(argv[log_index]));
   }
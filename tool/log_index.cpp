@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2017, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * Generate a sidecar index of a log, which is used by log_CSV and INS_GPS
+ * to seek the time range specified with --start_gpst and --end_gpst.
+ *
+ * Usage: (exe) [options] log.dat [out_file]
+ *   --interval=N    number of pages between index entries, default 256
+ * The default output is log.dat.idx.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <exception>
+
+#define IS_LITTLE_ENDIAN 1
+#include "SylphideProcessor.h"
+#include "SylphideLogIndex.h"
+#include "util/mapped_file.h"
+
+int main(int argc, char *argv[]){
+  unsigned int interval(0x100);
+  const char *log_fname(NULL), *out_fname(NULL);
+
+  for(int i(1); i < argc; ++i){
+    const char *arg(argv[i]);
+    if(std::strncmp(arg, "--interval=", 11) == 0){
+      int value(std::atoi(arg + 11));
+      if(value <= 0){
+        std::cerr << "Invalid option: " << arg << std::endl;
+        return -1;
+      }
+      interval = (unsigned int)value;
+    }else if(std::strncmp(arg, "--", 2) == 0){
+      std::cerr << "Invalid option: " << arg << std::endl;
+      return -1;
+    }else if(!log_fname){
+      log_fname = arg;
+    }else if(!out_fname){
+      out_fname = arg;
+    }else{
+      std::cerr << "Too many arguments: " << arg << std::endl;
+      return -1;
+    }
+  }
+  if(!log_fname){
+    std::cerr << "Usage: " << argv[0] << " [--interval=N] log.dat [out_file]" << std::endl;
+    return -1;
+  }
+  std::string index_fname(out_fname ? out_fname : SylphideLogIndex::index_fname(log_fname));
+
+  try{
+    MappedFile mapped(log_fname);
+    SylphideLogIndex index;
+    {
+      SylphideLogIndex::Generator<> generator(index, interval);
+      MappedFile::page_reader_t pages(mapped.pages(SYLPHIDE_PAGE_SIZE));
+      const char *page;
+      while(pages.next(page) == SYLPHIDE_PAGE_SIZE){
+        generator.process(page);
+      }
+    }
+    std::ofstream out(index_fname.c_str(), std::ios::out | std::ios::binary);
+    if(!out){
+      std::cerr << "Could not open " << index_fname << std::endl;
+      return -1;
+    }
+    index.save(out);
+    std::cerr << index_fname << ": " << index.entries.size() << " entries for "
+        << index.header.pages << " pages" << std::endl;
+  }catch(std::exception &e){
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
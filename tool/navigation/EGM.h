@@ -49,6 +49,7 @@
 
 template <class FloatT>
 struct EGM_Generic {
+  typedef FloatT float_t;
   struct coefficients_t {
     const FloatT c_bar;
     const FloatT s_bar;
@@ -56,38 +57,79 @@ struct EGM_Generic {
 
   protected:
 
+  /**
+   * Precomputed coefficients of the recursion of the normalized associated Legendre functions,
+   * p_bar[n][m] = a * cos(phi) * p_bar[n-1][m-1] + b * sin(phi) * p_bar[n-1][m] - c * p_bar[n-2][m],
+   * and d = sqrt((n - m) * (n + m + 1)) used for the derivative.
+   * The table is generated only once for each N_MAX.
+   */
+  template <int N_MAX>
+  struct p_bar_coef_t {
+    struct item_t {
+      FloatT a, b, c, d;
+    } items[(N_MAX + 1) * (N_MAX + 2) / 2];
+    const item_t &operator()(const unsigned int &n, const unsigned int &m) const {
+      return items[n * (n + 1) / 2 + m];
+    }
+    p_bar_coef_t() {
+      for(int n(0); n <= N_MAX; ++n){
+        for(int m(0); m <= n; ++m){
+          item_t &item(items[n * (n + 1) / 2 + m]);
+          item.a = item.b = item.c = 0;
+          item.d = std::sqrt(FloatT(n - m) * (n + m + 1));
+          if(n < 2){continue;}
+          if(m == 0){
+            item.b = std::sqrt(FloatT(2 * n + 1) / (2 * n - 1)) * (2 * n - 1) / n;
+            item.c = std::sqrt(FloatT(2 * n + 1) / (2 * n - 3)) * (n - 1) / n;
+          }else if(m <= n - 2){
+            FloatT d(std::sqrt(FloatT(2 * n + 1) / (n + m)) / n);
+            item.a = std::pow(FloatT((2 * n - 1) * (n + m - 1)), -0.5)
+                * std::sqrt(m == 1 ? 2.0 : 1.0) * m * (2 * n - 1) * d;
+            item.b = std::sqrt(FloatT(n - m) / (2 * n - 1)) * (2 * n - 1) * d;
+            item.c = std::sqrt(FloatT((n - m) * (n - m - 1)) / ((2 * n - 3) * (n + m - 1)))
+                * (n - 1) * d;
+          }else if(m == n - 1){
+            item.a = std::sqrt(FloatT((2 * n + 1) * (n - 1)) / 2)
+                * std::sqrt(n == 2 ? 2.0 : 1.0) / n;
+            item.b = std::sqrt(FloatT(2 * n + 1)) / n;
+          }else{ // m == n
+            item.a = std::sqrt(0.5 / n + 1);
+          }
+        }
+      }
+    }
+    static const p_bar_coef_t &get(){
+      static const p_bar_coef_t res;
+      return res;
+    }
+  };
+
   template <int N_MAX>
   struct p_bar_nm_t{
     unsigned int n_current;
     const FloatT sp, cp;
     FloatT p_bar_cache[3][N_MAX + 1];
     FloatT *p_bar[3];
+    const p_bar_coef_t<N_MAX> &coef;
 
     void next(
         const unsigned int &n,
         FloatT *p_bar_n,
         const FloatT *p_bar_n1, const FloatT *p_bar_n2) const {
-
       { // m = 0
-        FloatT b(std::sqrt(FloatT(2 * n + 1) / (2 * n - 1)));
-        FloatT c(std::sqrt(FloatT(2 * n + 1) / (2 * n - 3)));
-        p_bar_n[0] = (p_bar_n1[0] * sp * (2 * n - 1) * b - p_bar_n2[0] * (n - 1) * c) / n;
+        const typename p_bar_coef_t<N_MAX>::item_t &k(coef(n, 0));
+        p_bar_n[0] = k.b * sp * p_bar_n1[0] - k.c * p_bar_n2[0];
       }
-      for(int m(1); m <= (int)n - 2; ++m){ // 0 < m < n-1
-        FloatT a(std::pow(((2 * n - 1) * (n + m - 1)), -0.5) * std::sqrt(m == 1 ? 2.0 : 1.0));
-        FloatT b(std::sqrt(FloatT(n - m) / (2 * n - 1)));
-        FloatT c(std::sqrt(FloatT((n - m) * (n - m - 1)) / ((2 * n - 3) * (n + m - 1))));
-        p_bar_n[m] = (p_bar_n1[m - 1] * m * (2 * n - 1) * cp * a
-            + (p_bar_n1[m] * sp * (2 * n - 1) * b - p_bar_n2[m] * (n - 1) * c))
-              / n * std::sqrt(FloatT(2 * n + 1) / (n + m));
+      for(unsigned int m(1); m + 2 <= n; ++m){ // 0 < m < n-1
+        const typename p_bar_coef_t<N_MAX>::item_t &k(coef(n, m));
+        p_bar_n[m] = k.a * cp * p_bar_n1[m - 1] + k.b * sp * p_bar_n1[m] - k.c * p_bar_n2[m];
       }
       { // m = n-1
-        FloatT a(std::sqrt(FloatT((2 * n + 1) * (n - 1)) / 2) * std::sqrt(n == 2 ? 2.0 : 1.0));
-        FloatT b(std::sqrt(FloatT(2 * n + 1)));
-        p_bar_n[n - 1] = (p_bar_n1[n - 2] * cp * a + p_bar_n1[n - 1] * sp * b) / n;
+        const typename p_bar_coef_t<N_MAX>::item_t &k(coef(n, n - 1));
+        p_bar_n[n - 1] = k.a * cp * p_bar_n1[n - 2] + k.b * sp * p_bar_n1[n - 1];
       }
       { // m = n
-        p_bar_n[n] = p_bar_n1[n - 1] * cp * std::sqrt(0.5 / n + 1);
+        p_bar_n[n] = coef(n, n).a * cp * p_bar_n1[n - 1];
       }
     }
     p_bar_nm_t<N_MAX> &operator++(){
@@ -101,7 +143,8 @@ struct EGM_Generic {
       return *this;
     }
     p_bar_nm_t(const FloatT &phi)
-        : n_current(0), sp(std::sin(phi)), cp(std::cos(phi)) {
+        : n_current(0), sp(std::sin(phi)), cp(std::cos(phi)),
+        coef(p_bar_coef_t<N_MAX>::get()) {
       p_bar[0] = p_bar_cache[0];
       p_bar[1] = p_bar_cache[1];
       p_bar[2] = p_bar_cache[2];
@@ -119,6 +162,23 @@ struct EGM_Generic {
     }
   };
 
+  /**
+   * cos(lambda * m) and sin(lambda * m) by the angle addition formula,
+   * which requires only one pair of trigonometric function calls.
+   */
+  static void update_trigonometric(
+      const FloatT &lambda, FloatT *c_ml, FloatT *s_ml, const int &m_max){
+    c_ml[0] = 1;
+    s_ml[0] = 0;
+    if(m_max < 1){return;}
+    c_ml[1] = std::cos(lambda);
+    s_ml[1] = std::sin(lambda);
+    for(int m(2); m <= m_max; ++m){
+      c_ml[m] = c_ml[m - 1] * c_ml[1] - s_ml[m - 1] * s_ml[1];
+      s_ml[m] = s_ml[m - 1] * c_ml[1] + c_ml[m - 1] * s_ml[1];
+    }
+  }
+
   public:
 
   template <int N_MAX>
@@ -129,8 +189,9 @@ struct EGM_Generic {
     FloatT c_ml[N_MAX + 1], s_ml[N_MAX + 1];
     cache_t() : n_max(N_MAX) {}
     cache_t &update_a_r(const FloatT &a_r){
-      for(int k(0); k <= N_MAX; k++){
-        a_r_n[k] = std::pow(a_r, k);
+      a_r_n[0] = 1;
+      for(int k(1); k <= N_MAX; k++){
+        a_r_n[k] = a_r_n[k - 1] * a_r;
       }
       return *this;
     }
@@ -144,10 +205,7 @@ struct EGM_Generic {
       return *this;
     }
     cache_t &update_lambda(const FloatT &lambda){
-      for(int k(0); k <= N_MAX; k++){
-        c_ml[k] = std::cos(lambda * k);
-        s_ml[k] = std::sin(lambda * k);
-      }
+      update_trigonometric(lambda, c_ml, s_ml, N_MAX);
       return *this;
     }
     cache_t &update(const FloatT &a_r, const FloatT &phi, const FloatT &lambda){
@@ -165,10 +223,7 @@ struct EGM_Generic {
     FloatT c_ml[N_MAX + 1], s_ml[N_MAX + 1];
     buffer_t(const FloatT &a_r, const FloatT &phi, const FloatT &lambda)
         : p_bar_nm_t<N_MAX>(phi), a_r_orig(a_r), a_r_n(a_r) {
-      for(int m(0); m <= N_MAX; ++m){
-        c_ml[m] = std::cos(lambda * m);
-        s_ml[m] = std::sin(lambda * m);
-      }
+      update_trigonometric(lambda, c_ml, s_ml, N_MAX);
     }
     buffer_t &operator++(){
       p_bar_nm_t<N_MAX>::operator ++();
@@ -187,6 +242,7 @@ struct EGM_Generic {
       const coefficients_t coefs[],
       const cache_t<N_MAX> &x) {
 
+    const p_bar_coef_t<N_MAX> &coef(p_bar_coef_t<N_MAX>::get());
     calc_res_t sum_n = {1, 1, 0, 0};
     for(int n(2), coef_i(0); n <= x.n_max; n++){
       calc_res_t sum_m = {0, 0, 0, 0};
@@ -201,7 +257,7 @@ struct EGM_Generic {
         }
         if(GravityPhi){
           sum_m.gravity_phi += (-x.p_bar[n][m] * m * x.c_ml[1] * x.s_ml[1]
-                + ((m == n) ? 0 : std::sqrt(FloatT(n - m) * (n + m + 1)) * x.p_bar[n][m+1]))
+                + ((m == n) ? 0 : coef(n, m).d * x.p_bar[n][m+1]))
               * (coefs[coef_i].c_bar * x.c_ml[m] + coefs[coef_i].s_bar * x.s_ml[m]);
         }
         if(GravityLambda){
@@ -223,6 +279,7 @@ struct EGM_Generic {
       const FloatT &a_r, const FloatT &phi, const FloatT &lambda) {
 
     calc_res_t sum_n = {1, 1, 0, 0}; buffer_t<N_MAX> x(a_r, phi, lambda);
+    const p_bar_coef_t<N_MAX> &coef(x.coef);
     for(int n(2), coef_i(0); n <= N_MAX; n++){
       calc_res_t sum_m = {0, 0, 0, 0}; ++x;
       for(int m(0); m <= n; m++, coef_i++){
@@ -236,7 +293,7 @@ struct EGM_Generic {
         }
         if(GravityPhi){
           sum_m.gravity_phi += (-x.p_bar[0][m] * m * x.c_ml[1] * x.s_ml[1]
-                + ((m == n) ? 0 : std::sqrt(FloatT(n - m) * (n + m + 1)) * x.p_bar[0][m+1]))
+                + ((m == n) ? 0 : coef(n, m).d * x.p_bar[0][m+1]))
               * (coefs[coef_i].c_bar * x.c_ml[m] + coefs[coef_i].s_bar * x.s_ml[m]);
         }
         if(GravityLambda){
@@ -2968,4 +3025,62 @@ const typename EGM_Generic<FloatT>::coefficients_t EGM2008_70_Generic<FloatT>::c
 
 typedef EGM2008_70_Generic<double> EGM2008_70;
 
+/**
+ * Position-keyed cache of gravity.
+ * The last evaluation of the model is reused while the position stays within a tolerance,
+ * because the spherical harmonics expansion is too expensive to be evaluated at every IMU step.
+ * The reused value is scaled by the inverse square of the radius
+ * in order to absorb the dominant part of the change in altitude.
+ *
+ * @param EGM Earth gravity model having static gravity(r, phi, lambda)
+ */
+template <class EGM>
+struct EGM_GravityCache {
+  typedef typename EGM::float_t float_t;
+  typedef typename EGM::gravity_res_t gravity_res_t;
+
+  float_t tolerance; ///< Tolerance of the position [m]; zero or negative value disables the cache.
+  bool valid;
+  float_t r0, phi0, lambda0, r_cos_phi0;
+  gravity_res_t g0;
+
+  EGM_GravityCache(const float_t &tolerance_ = 0)
+      : tolerance(tolerance_), valid(false),
+      r0(0), phi0(0), lambda0(0), r_cos_phi0(0), g0() {}
+
+  void invalidate(){valid = false;}
+
+  /**
+   * Check whether a position is within the tolerance of the cached one.
+   */
+  bool hit(const float_t &r, const float_t &phi, const float_t &lambda) const {
+    if((!valid) || (tolerance <= 0)){return false;}
+    float_t d_r(r - r0), d_n(r0 * (phi - phi0)), d_e(r_cos_phi0 * (lambda - lambda0));
+    return (d_r * d_r + d_n * d_n + d_e * d_e) <= (tolerance * tolerance);
+  }
+
+  /**
+   * Return gravity in the same way as EGM::gravity(r, phi, lambda)
+   *
+   * @param r geocentric radius [m]
+   * @param phi geocentric latitude [rad]
+   * @param lambda longitude [rad]
+   */
+  gravity_res_t gravity(const float_t &r, const float_t &phi, const float_t &lambda){
+    if(hit(r, phi, lambda)){
+      float_t sf(r0 / r);
+      sf *= sf;
+      gravity_res_t res = {g0.r * sf, g0.phi * sf, g0.lambda * sf};
+      return res;
+    }
+    g0 = EGM::gravity(r, phi, lambda);
+    r0 = r;
+    phi0 = phi;
+    lambda0 = lambda;
+    r_cos_phi0 = r * std::cos(phi);
+    valid = true;
+    return g0;
+  }
+};
+
 #endif /* __EGM_H__ */
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2017, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** @file
+ * @brief Precomputed grid of Earth gravity model
+ *
+ * Gravity of an Earth gravity model is tabulated over a region
+ * in advance, and then trilinearly interpolated,
+ * which replaces the spherical harmonics expansion with a few memory loads.
+ */
+
+#ifndef __EGM_GRID_H__
+#define __EGM_GRID_H__
+
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <ios>
+#include <ostream>
+#include <vector>
+#include <string>
+
+#include "EGM.h"
+#include "util/mapped_file.h"
+
+/**
+ * Earth gravity model backed by a precomputed grid.
+ * It has the same static interface as EGM, and therefore can be used as the EGM
+ * template argument of INS_EGM.
+ * When no grid is activated, or the position is out of the grid,
+ * the original model is evaluated instead.
+ *
+ * The grid axes are geocentric latitude, longitude, and height above the ellipsoid
+ * measured along the geocentric radius.
+ * Each node holds gravity multiplied by (r / R_e)^2, which is smooth along the height axis.
+ * Crossing the anti-meridian is not supported.
+ *
+ * @param EGM original Earth gravity model, such as EGM2008_70
+ */
+template <class EGM>
+struct EGM_Grid {
+  typedef typename EGM::float_t float_t;
+  typedef typename EGM::gravity_res_t gravity_res_t;
+  typedef float value_t;
+
+  struct header_t {
+    char magic[8]; ///< "EGMGRID"
+    int version;
+    int value_size; ///< sizeof(value_t)
+    int num[3]; ///< number of nodes along latitude, longitude, and height axes
+    int reserved;
+    double origin[3]; ///< first nodes; geocentric latitude [rad], longitude [rad], height [m]
+    double step[3]; ///< intervals of nodes; [rad], [rad], [m]
+    double max_error[3]; ///< interpolation error of r, phi, and lambda components [m/s^2]
+
+    static const int current_version = 1;
+
+    /**
+     * Constructor; the region (num, origin, and step) should be set afterward.
+     */
+    header_t() : version(current_version), value_size(sizeof(value_t)), reserved(0) {
+      std::memcpy(magic, "EGMGRID", sizeof(magic));
+      for(int i(0); i < 3; ++i){
+        num[i] = 0;
+        origin[i] = step[i] = max_error[i] = 0;
+      }
+    }
+    bool is_valid() const {
+      if((std::memcmp(magic, "EGMGRID", sizeof(magic)) != 0)
+          || (version != current_version)
+          || (value_size != sizeof(value_t))){
+        return false;
+      }
+      for(int i(0); i < 3; ++i){
+        if((num[i] < 2) || !(step[i] > 0)){return false;}
+      }
+      return true;
+    }
+    std::size_t nodes() const {
+      return (std::size_t)num[0] * num[1] * num[2];
+    }
+    std::size_t values() const {
+      return nodes() * 3;
+    }
+  };
+
+  /**
+   * Geocentric radius of the ellipsoid
+   *
+   * @param cos_phi cosine of geocentric latitude
+   */
+  static float_t radius_ellipsoid(const float_t &cos_phi){
+    typedef WGS84Generic<float_t> earth_t;
+    return earth_t::R_e * (1. - earth_t::F_e)
+        / std::sqrt(1. - earth_t::epsilon_Earth * earth_t::epsilon_Earth * cos_phi * cos_phi);
+  }
+
+  /**
+   * Read-only grid, whose values are stored in external memory.
+   */
+  struct view_t {
+    const header_t *header;
+    const value_t *values;
+
+    /**
+     * Interpolate gravity trilinearly.
+     *
+     * @param r geocentric radius [m]
+     * @param phi geocentric latitude [rad]
+     * @param lambda longitude [rad]
+     * @param res interpolated gravity, which is valid only when true is returned
+     * @return (bool) true when the position is inside of the grid
+     */
+    bool interpolate(
+        const float_t &r, const float_t &phi, const float_t &lambda,
+        gravity_res_t &res) const {
+      float_t x[3] = {phi, lambda, r - radius_ellipsoid(std::cos(phi))};
+      int idx[3];
+      float_t w[3];
+      for(int i(0); i < 3; ++i){
+        float_t t((x[i] - header->origin[i]) / header->step[i]);
+        if(!(t >= 0) || (t > (header->num[i] - 1))){return false;}
+        idx[i] = (int)t;
+        if(idx[i] > header->num[i] - 2){idx[i] = header->num[i] - 2;}
+        w[i] = t - idx[i];
+      }
+      const std::size_t
+          stride_h(3),
+          stride_lambda(stride_h * header->num[2]),
+          stride_phi(stride_lambda * header->num[1]);
+      const value_t *v(values
+          + (stride_phi * idx[0]) + (stride_lambda * idx[1]) + (stride_h * idx[2]));
+      float_t sum[3] = {0};
+      for(int i(0); i < 2; ++i){
+        float_t w_i(i ? w[0] : (1 - w[0]));
+        for(int j(0); j < 2; ++j){
+          float_t w_ij(w_i * (j ? w[1] : (1 - w[1])));
+          const value_t *v_ij(v + (stride_phi * i) + (stride_lambda * j));
+          for(int k(0); k < 2; ++k){
+            float_t w_ijk(w_ij * (k ? w[2] : (1 - w[2])));
+            for(int l(0); l < 3; ++l){
+              sum[l] += w_ijk * v_ij[stride_h * k + l];
+            }
+          }
+        }
+      }
+      float_t sf(WGS84Generic<float_t>::R_e / r);
+      sf *= sf;
+      res.r = sum[0] * sf;
+      res.phi = sum[1] * sf;
+      res.lambda = sum[2] * sf;
+      return true;
+    }
+  };
+
+  /**
+   * Grid owning its storage, which is loaded from a file with memory mapping,
+   * or generated on memory.
+   */
+  class grid_t : public view_t {
+    protected:
+      MappedFile *mapped;
+      header_t header_buf;
+      std::vector<value_t> values_buf;
+
+    private:
+      grid_t(const grid_t &);
+      grid_t &operator=(const grid_t &);
+
+    public:
+      /**
+       * Load a grid file
+       *
+       * @param fname file name
+       * @throws std::ios_base::failure when the file is not a valid grid
+       */
+      grid_t(const char *fname) : view_t(), mapped(new MappedFile(fname)) {
+        if((mapped->size() < sizeof(header_t))
+            || !(reinterpret_cast<const header_t *>(mapped->data())->is_valid())
+            || (mapped->size() < sizeof(header_t)
+              + sizeof(value_t) * reinterpret_cast<const header_t *>(mapped->data())->values())){
+          delete mapped;
+          throw std::ios_base::failure(std::string("Invalid gravity grid ").append(fname));
+        }
+        view_t::header = reinterpret_cast<const header_t *>(mapped->data());
+        view_t::values = reinterpret_cast<const value_t *>(mapped->data() + sizeof(header_t));
+      }
+
+      /**
+       * Generate a grid on memory
+       *
+       * @param spec region of the grid, whose max_error will be updated
+       */
+      grid_t(const header_t &spec) : view_t(), mapped(NULL), header_buf(spec) {
+        generate(header_buf, values_buf);
+        view_t::header = &header_buf;
+        view_t::values = &values_buf[0];
+      }
+
+      ~grid_t(){
+        if(current() == this){current() = NULL;}
+        delete mapped;
+      }
+
+      /**
+       * Make EGM_Grid<EGM>::gravity() use this grid.
+       */
+      void activate() const {
+        current() = this;
+      }
+
+      /**
+       * Save the grid, which can be loaded with grid_t(const char *).
+       */
+      void save(std::ostream &out) const {
+        out.write(reinterpret_cast<const char *>(view_t::header), sizeof(header_t));
+        out.write(reinterpret_cast<const char *>(view_t::values),
+            sizeof(value_t) * view_t::header->values());
+      }
+  };
+
+  /**
+   * Calculate values of a grid with the original model.
+   * Interpolation error is estimated at the center of every cell,
+   * and its maximum is stored into the header.
+   *
+   * @param header region of the grid
+   * @param values buffer to be filled
+   */
+  static void generate(header_t &header, std::vector<value_t> &values){
+    values.resize(header.values());
+    value_t *v(&values[0]);
+    for(int i(0); i < header.num[0]; ++i){
+      float_t phi(header.origin[0] + header.step[0] * i);
+      float_t r_e(radius_ellipsoid(std::cos(phi)));
+      for(int j(0); j < header.num[1]; ++j){
+        float_t lambda(header.origin[1] + header.step[1] * j);
+        for(int k(0); k < header.num[2]; ++k, v += 3){
+          float_t r(r_e + header.origin[2] + header.step[2] * k);
+          gravity_res_t g(EGM::gravity(r, phi, lambda));
+          float_t sf(r / WGS84Generic<float_t>::R_e);
+          sf *= sf;
+          v[0] = (value_t)(g.r * sf);
+          v[1] = (value_t)(g.phi * sf);
+          v[2] = (value_t)(g.lambda * sf);
+        }
+      }
+    }
+
+    view_t view = {&header, &values[0]};
+    for(int l(0); l < 3; ++l){header.max_error[l] = 0;}
+    for(int i(0); i < header.num[0] - 1; ++i){
+      float_t phi(header.origin[0] + header.step[0] * (0.5 + i));
+      float_t r_e(radius_ellipsoid(std::cos(phi)));
+      for(int j(0); j < header.num[1] - 1; ++j){
+        float_t lambda(header.origin[1] + header.step[1] * (0.5 + j));
+        for(int k(0); k < header.num[2] - 1; ++k){
+          float_t r(r_e + header.origin[2] + header.step[2] * (0.5 + k));
+          gravity_res_t g(EGM::gravity(r, phi, lambda)), g_grid;
+          if(!view.interpolate(r, phi, lambda, g_grid)){continue;} // outside of the grid
+          float_t err[3] = {
+            std::abs(g.r - g_grid.r), std::abs(g.phi - g_grid.phi), std::abs(g.lambda - g_grid.lambda)};
+          for(int l(0); l < 3; ++l){
+            if(err[l] > header.max_error[l]){header.max_error[l] = err[l];}
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * Currently activated grid
+   */
+  static const view_t *&current(){
+    static const view_t *res(NULL);
+    return res;
+  }
+
+  static gravity_res_t gravity(
+      const float_t &r, const float_t &phi, const float_t &lambda){
+    const view_t *grid(current());
+    gravity_res_t res;
+    if(grid && grid->interpolate(r, phi, lambda, res)){return res;}
+    return EGM::gravity(r, phi, lambda);
+  }
+};
+
+#endif /* __EGM_GRID_H__ */
@@ -31,6 +31,7 @@
 #include "INS.h"
 #include "param/matrix.h"
 #include "algorithm/kalman.h"
+#include "algorithm/kalman_fixed.h"
 
 template <class FloatT>
 struct CorrectInfo {
@@ -67,6 +68,20 @@ class Filtered_INS2_Property {
         ; ///< Qs(͌덷Us)̑傫
 };
 
+template <class FloatT>
+struct Filtered_INS2_MultiRate_Property {
+  /**
+   * Interval [s] of covariance propagation.
+   * Time updates of the covariance are accumulated until the interval elapses,
+   * or until the next measurement update, while the INS is updated at every step.
+   * Zero (default) or negative values mean propagation at every step.
+   * Because before_update_INS() is then invoked once per interval,
+   * it is not supported by the snapshots of INS_GPS_Back_Propagate and INS_GPS_RealTime.
+   */
+  FloatT predict_interval;
+  Filtered_INS2_MultiRate_Property() : predict_interval(0) {}
+};
+
 #if !defined(_MSC_VER)
 template <class BaseINS>
 const unsigned Filtered_INS2_Property<BaseINS>::P_SIZE = BaseINS::STATE_VALUES - 2;
@@ -102,7 +117,8 @@ template <
     template <class> class Filter = KalmanFilterUD>
 class Filtered_INS2
     : public BaseINS,
-      public Filtered_INS2_Property<BaseINS> {
+      public Filtered_INS2_Property<BaseINS>,
+      protected Filtered_INS2_MultiRate_Property<typename BaseINS::float_t> {
   public:
     typedef BaseINS ins_t;
 #if defined(__GNUC__) && (__GNUC__ < 5)
@@ -116,11 +132,14 @@ class Filtered_INS2
 #endif
     typedef Matrix<float_t> mat_t;
 
-    typedef Filter<float_t> filter_t;
     typedef Filtered_INS2_Property<ins_t> property_t;
+    typedef Filtered_INS2_MultiRate_Property<float_t> multi_rate_property_t;
 
     using property_t::P_SIZE;
     using property_t::Q_SIZE;
+
+    typedef KalmanFilter_Builder<Filter<float_t>, P_SIZE, Q_SIZE> filter_builder_t;
+    typedef typename filter_builder_t::filter_t filter_t;
     
   protected:
     filter_t m_filter;  ///< J}tB^{
@@ -144,20 +163,160 @@ class Filtered_INS2
           }
         }
       }
-      mat_t getA() const {
-        return mat_t(
+      template <class MatrixT>
+      MatrixT getA() const {
+        return MatrixT(
             sizeof(A) / sizeof(A[0]),
             sizeof(A[0]) / sizeof(A[0][0]),
             (float_t *)&A);
       }
-      mat_t getB() const {
-        return mat_t(
+      template <class MatrixT>
+      MatrixT getB() const {
+        return MatrixT(
             sizeof(B) / sizeof(B[0]),
             sizeof(B[0]) / sizeof(B[0][0]),
             (float_t *)&B);
       }
+      mat_t getA() const {return getA<mat_t>();}
+      mat_t getB() const {return getB<mat_t>();}
+
+      /**
+       * Discretized factors of time update, which are computed once per step by discretize(),
+       * and are shared by the filter and the callback before_update_INS().
+       */
+      float_t Phi[P_SIZE][P_SIZE]; ///< @f$ \Phi = I + A \Delta t @f$
+      float_t Gamma[P_SIZE][Q_SIZE]; ///< @f$ \Gamma = B \Delta t @f$
+      float_t deltaT;
+
+      /**
+       * Compute @f$ \Phi @f$ and @f$ \Gamma @f$ with the first-order approximation.
+       *
+       * @param _deltaT interval time
+       */
+      void discretize(const float_t &_deltaT){
+        discretize(_deltaT, _deltaT);
+      }
+      /**
+       * Compute @f$ \Phi = I + A \Delta t @f$ and @f$ \Gamma = B \Delta t' @f$,
+       * whose time for @f$ \Gamma @f$ is different.
+       * When A and B are averaged over steps, whose intervals are @f$ \delta t_{i} @f$,
+       * @f$ \Delta t = \sum \delta t_{i} @f$ and @f$ \Delta t' = \sqrt{\sum \delta t_{i}^{2}} @f$
+       * result in @f$ \Gamma Q \Gamma^{T} = \sum B Q B^{T} \delta t_{i}^{2} @f$,
+       * i.e., the sum of the input noise of the steps.
+       *
+       * @param _deltaT interval time for @f$ \Phi @f$
+       * @param deltaT_Gamma interval time for @f$ \Gamma @f$
+       */
+      void discretize(const float_t &_deltaT, const float_t &deltaT_Gamma){
+        deltaT = _deltaT;
+        for(unsigned int i(0); i < P_SIZE; ++i){
+          for(unsigned int j(0); j < P_SIZE; ++j){
+            Phi[i][j] = A[i][j] * deltaT;
+          }
+          Phi[i][i] += 1;
+          for(unsigned int j(0); j < Q_SIZE; ++j){
+            Gamma[i][j] = B[i][j] * deltaT_Gamma;
+          }
+        }
+      }
+      template <class MatrixT>
+      MatrixT getPhi() const {
+        return MatrixT(P_SIZE, P_SIZE, (float_t *)&Phi);
+      }
+      template <class MatrixT>
+      MatrixT getGamma() const {
+        return MatrixT(P_SIZE, Q_SIZE, (float_t *)&Gamma);
+      }
+      mat_t getPhi() const {return getPhi<mat_t>();}
+      mat_t getGamma() const {return getGamma<mat_t>();}
+      /**
+       * Inverse of @f$ \Phi @f$ with the first-order identity
+       * @f$ \Phi^{-1} = (I + A \Delta t)^{-1} \approx I - A \Delta t @f$,
+       * which has the same order of accuracy as @f$ \Phi @f$ itself.
+       */
+      mat_t getPhi_inv() const {
+        mat_t res(P_SIZE, P_SIZE);
+        for(unsigned int i(0); i < P_SIZE; ++i){
+          for(unsigned int j(0); j < P_SIZE; ++j){
+            res(i, j) = -A[i][j] * deltaT;
+          }
+          res(i, i) += 1;
+        }
+        return res;
+      }
     };
 
+    /**
+     * Time updates of the covariance, which are accumulated but not applied yet.
+     * @see Filtered_INS2_MultiRate_Property
+     */
+    struct predict_batch_t {
+      getAB_res AB; ///< sum of A * deltaT and B * deltaT
+      float_t deltaT; ///< sum of deltaT
+      float_t deltaT2; ///< sum of deltaT^2
+      unsigned int steps;
+      predict_batch_t() : AB(), deltaT(0), deltaT2(0), steps(0) {}
+      void add(const getAB_res &_AB, const float_t &_deltaT){
+        for(unsigned int i(0); i < P_SIZE; ++i){
+          for(unsigned int j(0); j < P_SIZE; ++j){
+            AB.A[i][j] += _AB.A[i][j] * _deltaT;
+          }
+          for(unsigned int j(0); j < Q_SIZE; ++j){
+            AB.B[i][j] += _AB.B[i][j] * _deltaT;
+          }
+        }
+        deltaT += _deltaT;
+        deltaT2 += _deltaT * _deltaT;
+        ++steps;
+      }
+      /**
+       * Get averaged A and B, and the corresponding discretized factors.
+       * They approximate the product of @f$ (I + A \delta t_{i}) @f$ of the steps
+       * up to the second order, which becomes dominant as the number of the steps increases.
+       * With @f$ S = \sum A \delta t_{i} @f$ and
+       * @f$ c = (1 - \sum \delta t_{i}^{2} / (\sum \delta t_{i})^{2}) / 2 @f$,
+       * which is @f$ (N - 1) / 2N @f$ for N steps of the same interval,
+       * @f$ \Phi = I + S + c S^{2} @f$ and @f$ \Gamma = (I + c S) B \Delta t' @f$.
+       * The latter means that the input noise is propagated from the middle of the interval.
+       */
+      void get(getAB_res &res) const {
+        for(unsigned int i(0); i < P_SIZE; ++i){
+          for(unsigned int j(0); j < P_SIZE; ++j){
+            res.A[i][j] = AB.A[i][j] / deltaT;
+          }
+          for(unsigned int j(0); j < Q_SIZE; ++j){
+            res.B[i][j] = AB.B[i][j] / deltaT;
+          }
+        }
+        res.discretize(deltaT, std::sqrt(deltaT2));
+        if(steps < 2){return;}
+        const float_t c((1 - deltaT2 / (deltaT * deltaT)) / 2);
+        float_t Gamma[P_SIZE][Q_SIZE];
+        for(unsigned int i(0); i < P_SIZE; ++i){
+          for(unsigned int j(0); j < P_SIZE; ++j){
+            float_t S2(0);
+            for(unsigned int k(0); k < P_SIZE; ++k){
+              if(AB.A[k][j] == 0){continue;}
+              S2 += AB.A[i][k] * AB.A[k][j];
+            }
+            res.Phi[i][j] += S2 * c;
+          }
+          for(unsigned int j(0); j < Q_SIZE; ++j){
+            float_t SG(0);
+            for(unsigned int k(0); k < P_SIZE; ++k){
+              SG += AB.A[i][k] * res.Gamma[k][j];
+            }
+            Gamma[i][j] = res.Gamma[i][j] + SG * c;
+          }
+        }
+        for(unsigned int i(0); i < P_SIZE; ++i){
+          for(unsigned int j(0); j < Q_SIZE; ++j){
+            res.Gamma[i][j] = Gamma[i][j];
+          }
+        }
+      }
+    } m_predict_batch;
+
     /**
      * q@(VXe)ɂāA
      * ̏ԗʂ̌덷ɑ΂Đ`ꍇ̎A
@@ -180,8 +339,10 @@ class Filtered_INS2
         getAB_res &res) const {
 
       // ]švZ
-      mat_t dcm_e2n((this->q_e2n).getDCM()); ///< @f$ \mathrm{DCM} \left( \Tilde{q}_{e}^{n} \right) @f$
-      mat_t dcm_n2b((this->q_n2b).getDCM()); ///< @f$ \mathrm{DCM} \left( \Tilde{q}_{n}^{b} \right) @f$
+      // refreshed by BaseINS::recalc(), therefore neither allocation nor normalization is required
+      const typename BaseINS::rotation_cache_t &rot(this->rotation_cache);
+#define dcm_e2n(i, j) rot.dcm_e2n[i][j] // @f$ \mathrm{DCM} \left( \Tilde{q}_{e}^{n} \right) @f$
+#define dcm_n2b(i, j) rot.dcm_n2b[i][j] // @f$ \mathrm{DCM} \left( \Tilde{q}_{n}^{b} \right) @f$
       
 #ifndef pow2
 #define pow2(x) ((x) * (x))
@@ -381,6 +542,8 @@ class Filtered_INS2
         B(9, 5) = dcm_n2b(2, 2) / 2;
 #undef B
       }
+#undef dcm_e2n
+#undef dcm_n2b
     }
   
   public:
@@ -392,8 +555,9 @@ class Filtered_INS2
      * 
      */
     Filtered_INS2() 
-        : BaseINS(),
-          m_filter(mat_t::getI(P_SIZE), mat_t::getI(Q_SIZE)){
+        : BaseINS(), multi_rate_property_t(),
+          m_filter(mat_t::getI(P_SIZE), mat_t::getI(Q_SIZE)),
+          m_predict_batch() {
     }
     
     /**
@@ -405,7 +569,7 @@ class Filtered_INS2
      * @param Q Qs(͌덷Us)
      */
     Filtered_INS2(const mat_t &P, const mat_t &Q)
-        : BaseINS(), m_filter(P, Q) {}
+        : BaseINS(), multi_rate_property_t(), m_filter(P, Q), m_predict_batch() {}
     
     /**
      * Rs[RXgN^
@@ -414,23 +578,27 @@ class Filtered_INS2
      * @param deepcopy fB[vRs[쐬邩ǂ
      */
     Filtered_INS2(const Filtered_INS2 &orig, const bool &deepcopy = false)
-        : BaseINS(orig, deepcopy),
-          m_filter(orig.m_filter, deepcopy){
+        : BaseINS(orig, deepcopy), multi_rate_property_t(orig),
+          m_filter(orig.m_filter, deepcopy),
+          m_predict_batch(orig.m_predict_batch){
     }
     
     virtual ~Filtered_INS2(){}
 
+    void setup_multi_rate(const multi_rate_property_t &property){
+      multi_rate_property_t::operator=(property);
+    }
+
   protected:
     /**
      * ԍXVɂČ㏈邽߂̃R[obN֐B
      * ftHgł͉܂B
      * 
-     * @param A As
-     * @param B Bs
+     * @param AB A, Bs
      * @param deltaT ԊԊu
      */
     virtual inline void before_update_INS(
-        const mat_t &A, const mat_t &B,
+        const getAB_res &AB,
         const float_t &deltaT
       ){}
       
@@ -445,15 +613,40 @@ class Filtered_INS2
     void update(const vec3_t &accel, const vec3_t &gyro, const float_t &deltaT){
       getAB_res AB;
       getAB(accel, gyro, AB);
-      mat_t A(AB.getA()), B(AB.getB());
+      if(multi_rate_property_t::predict_interval > 0){
+        m_predict_batch.add(AB, deltaT);
+        if(m_predict_batch.deltaT >= multi_rate_property_t::predict_interval){
+          predict_batch();
+        }
+        BaseINS::update(accel, gyro, deltaT);
+        return;
+      }
       //std::cerr << "deltaT:" << deltaT << std::endl;
       //std::cerr << "A:" << A << std::endl;
       //std::cerr << "B:" << B << std::endl;
       //std::cerr << "P:" << m_filter.getP() << std::endl;
-      m_filter.predict(A, B, deltaT);
-      before_update_INS(A, B, deltaT);
+      AB.discretize(deltaT);
+      m_filter.predict(
+          AB.template getPhi<typename filter_builder_t::mat_A_t>(),
+          AB.template getGamma<typename filter_builder_t::mat_B_t>());
+      before_update_INS(AB, deltaT);
       BaseINS::update(accel, gyro, deltaT);
     }
+
+    /**
+     * Apply the accumulated time updates to the covariance.
+     * It is invoked automatically before measurement updates and access to the filter.
+     */
+    void predict_batch(){
+      if(m_predict_batch.steps == 0){return;}
+      getAB_res AB;
+      m_predict_batch.get(AB);
+      m_predict_batch = predict_batch_t(); // reset before the callback, which may access the filter
+      m_filter.predict(
+          AB.template getPhi<typename filter_builder_t::mat_A_t>(),
+          AB.template getGamma<typename filter_builder_t::mat_B_t>());
+      before_update_INS(AB, AB.deltaT);
+    }
   
   protected:
     /**
@@ -517,6 +710,7 @@ class Filtered_INS2
      * @param R 덷Us
      */
     void correct_primitive(const mat_t &H, const mat_t &z, const mat_t &R){
+      predict_batch();
             
       // Cʂ̌vZ
       mat_t K(m_filter.correct(H, R)); //J}QC
@@ -541,6 +735,7 @@ class Filtered_INS2
      * @param sigma2_delta_psi delta_psi̊m炵(U) [rad^2]
      */
     void correct_yaw(const float_t &delta_psi, const float_t &sigma2_delta_psi){
+      predict_batch();
 
       //ϑz
       float_t z_serialized[1][1] = {{-delta_psi}};
@@ -574,7 +769,21 @@ class Filtered_INS2
      * 
      * @return (Filter &) tB^[
      */
-    filter_t &getFilter(){return m_filter;}
+    filter_t &getFilter(){
+      predict_batch();
+      return m_filter;
+    }
+
+    /**
+     * Get the filter without applying the accumulated time updates, which is intended for output.
+     * Its covariance lags behind the INS by up to predict_interval.
+     *
+     * @return (Filter &) filter
+     * @see Filtered_INS2_MultiRate_Property
+     */
+    filter_t &getFilter_unpropagated() const {
+      return const_cast<filter_t &>(m_filter);
+    }
 
     struct StandardDeviations {
       float_t v_north_ms, v_east_ms, v_down_ms;
@@ -591,8 +800,7 @@ class Filtered_INS2
     StandardDeviations getSigma() const {
       StandardDeviations sigma;
 
-      const mat_t &P(
-          const_cast<Filtered_INS2 *>(this)->getFilter().getP());
+      const mat_t &P(getFilter_unpropagated().getP()); // may lag, see getFilter_unpropagated()
 
       { // x
         sigma.v_north_ms = std::sqrt(P(0, 0));
@@ -601,7 +809,7 @@ class Filtered_INS2
       }
 
       { // ʒu
-        float_t cl(std::cos(BaseINS::lambda)), sl(std::sin(BaseINS::lambda));
+        const float_t &cl(BaseINS::rotation_cache.cos_lambda), &sl(BaseINS::rotation_cache.sin_lambda);
 
         mat_t M(2, 3);
 
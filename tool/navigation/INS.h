@@ -79,6 +79,71 @@ class INS {
     vec3_t omega_e2i_4n;  ///< @f$ \vec{\omega}_{e/i}^{n} @f$
     vec3_t omega_n2e_4n;  ///< @f$ \vec{\omega}_{n/e}^{n} @f$
     
+    /**
+     * Rotation matrices and trigonometric values derived from
+     * @f$ \Tilde{q}_{e}^{n} @f$ and @f$ \Tilde{q}_{n}^{b} @f$.
+     * They are refreshed whenever the quaternions are changed by this class, i.e., in recalc(),
+     * and held in fixed size storage so that consumers invoked at every step,
+     * such as Jacobian calculation of filters, need neither allocation nor normalization.
+     */
+    struct rotation_cache_t {
+      float_t dcm_e2n[3][3]; ///< @f$ \mathrm{DCM} \left( \Tilde{q}_{e}^{n} \right) @f$
+      float_t dcm_n2b[3][3]; ///< @f$ \mathrm{DCM} \left( \Tilde{q}_{n}^{b} \right) @f$
+      float_t sin_phi, cos_phi, sin_lambda, cos_lambda, sin_alpha, cos_alpha;
+      
+      /**
+       * Calculate DCM equivalent to Quaternion::getDCM(), whose regularization is
+       * performed by division with the squared norm.
+       */
+      static void set_dcm(float_t (&dcm)[3][3], const quat_t &q){
+        float_t q0(q.get(0)), q1(q.get(1)), q2(q.get(2)), q3(q.get(3));
+        float_t n2(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+        float_t k(n2 > 0 ? (float_t(2) / n2) : float_t(2));
+        dcm[0][0] = float_t(1) - (q2 * q2 + q3 * q3) * k;
+        dcm[0][1] = (q1 * q2 + q0 * q3) * k;
+        dcm[0][2] = (q1 * q3 - q0 * q2) * k;
+        dcm[1][0] = (q1 * q2 - q0 * q3) * k;
+        dcm[1][1] = float_t(1) - (q1 * q1 + q3 * q3) * k;
+        dcm[1][2] = (q2 * q3 + q0 * q1) * k;
+        dcm[2][0] = (q1 * q3 + q0 * q2) * k;
+        dcm[2][1] = (q2 * q3 - q0 * q1) * k;
+        dcm[2][2] = float_t(1) - (q1 * q1 + q2 * q2) * k;
+      }
+      
+      /**
+       * Update values related to @f$ \Tilde{q}_{e}^{n} @f$.
+       * The trigonometric values are extracted from the DCM, whose third row is
+       * @f$ \left( -\cos \lambda \cos \phi, -\sin \lambda \cos \phi, -\sin \phi \right) @f$,
+       * and third column is
+       * @f$ \left( \cos \alpha \cos \phi, -\sin \alpha \cos \phi, -\sin \phi \right)^{T} @f$.
+       * Only at the poles, where they are indeterminate, the angles are used.
+       */
+      void update_e2n(const quat_t &q_e2n,
+          const float_t &lambda, const float_t &alpha){
+        set_dcm(dcm_e2n, q_e2n);
+        sin_phi = -dcm_e2n[2][2];
+        cos_phi = std::sqrt(pow2(dcm_e2n[2][0]) + pow2(dcm_e2n[2][1]));
+        if(cos_phi > 0){
+          cos_lambda = -dcm_e2n[2][0] / cos_phi;
+          sin_lambda = -dcm_e2n[2][1] / cos_phi;
+          cos_alpha = dcm_e2n[0][2] / cos_phi;
+          sin_alpha = -dcm_e2n[1][2] / cos_phi;
+        }else{
+          cos_lambda = std::cos(lambda);
+          sin_lambda = std::sin(lambda);
+          cos_alpha = std::cos(alpha);
+          sin_alpha = std::sin(alpha);
+        }
+      }
+      
+      /**
+       * Update values related to @f$ \Tilde{q}_{n}^{b} @f$.
+       */
+      void update_n2b(const quat_t &q_n2b){
+        set_dcm(dcm_n2b, q_n2b);
+      }
+    } rotation_cache;
+    
   public:
     typedef WGS84Generic<float_t> Earth; ///< nf
     static const unsigned STATE_VALUES = INS_Property<INS>::STATE_VALUES;
@@ -93,7 +158,7 @@ class INS {
      * 
      * @return (float_t) ]猻݈ʒu܂ł̋
      */
-    float_t beta() const{return (Earth::R_normal(phi) + h) * std::cos(phi);}
+    float_t beta() const{return (Earth::R_normal(phi) + h) * rotation_cache.cos_phi;}
   
   private:
     /**
@@ -157,7 +222,7 @@ class INS {
      * @return (vec3_t &)
      */
     inline vec3_t &update_omega_e2i_4n(){
-      return omega_e2i_4n = (q_e2n.conj() * omega_e2i_4e * q_e2n).vector();
+      return omega_e2i_4n = q_e2n.conj().rotate(omega_e2i_4e);
     }
     /**
      * ݈ʒuł@f$ \vec{\omega}_{n/e}^{n} @f$߂܂B
@@ -183,7 +248,7 @@ class INS {
      * @return (vec3_t &)
      */
     inline vec3_t &update_omega_n2e_4n(){
-      return update_omega_n2e_4n(std::cos(alpha), std::sin(alpha));
+      return update_omega_n2e_4n(rotation_cache.cos_alpha, rotation_cache.sin_alpha);
     }
   protected:
     /**
@@ -203,7 +268,11 @@ class INS {
       update_lambda();
       update_alpha();
       
-      float_t ca(std::cos(alpha)), sa(std::sin(alpha));
+      //]sƎOp֐l̍XV
+      rotation_cache.update_e2n(q_e2n, lambda, alpha);
+      rotation_cache.update_n2b(q_n2b);
+      
+      const float_t &ca(rotation_cache.cos_alpha), &sa(rotation_cache.sin_alpha);
 
       //v_north, v_east̍XV
       update_v_N(ca, sa);
@@ -241,6 +310,7 @@ class INS {
       q_e2n[3] = sl * (cp + sp) / sqrt2;
       h = height;
       
+      rotation_cache.update_e2n(q_e2n, lambda, alpha);
       update_omega_e2i_4n();
       update_omega_n2e_4n();
     }
@@ -310,6 +380,7 @@ class INS {
      */
     void initAttitude(const float_t &yaw, const float_t &pitch, const float_t &roll){
       euler2q_internal(yaw, pitch, roll, q_n2b);
+      rotation_cache.update_n2b(q_n2b);
     }
     
     /**
@@ -319,6 +390,7 @@ class INS {
      */
     void initAttitude(const quat_t &q){
       q_n2b = q.copy();
+      rotation_cache.update_n2b(q_n2b);
     }
   
     /**
@@ -345,7 +417,8 @@ class INS {
       q_n2b(deepcopy ? orig.q_n2b.copy() : orig.q_n2b), 
       omega_e2i_4e(deepcopy ? orig.omega_e2i_4e.copy() : orig.omega_e2i_4e), 
       omega_e2i_4n(deepcopy ? orig.omega_e2i_4n.copy() : orig.omega_e2i_4n), 
-      omega_n2e_4n(deepcopy ? orig.omega_n2e_4n.copy() : orig.omega_n2e_4n){
+      omega_n2e_4n(deepcopy ? orig.omega_n2e_4n.copy() : orig.omega_n2e_4n),
+      rotation_cache(orig.rotation_cache){
     }
     
     /**
@@ -397,6 +470,28 @@ class INS {
     void set(const unsigned &index, const float_t &v){
       (*this)[index] = v;
     }
+
+    /**
+     * Export all state values at once.
+     *
+     * @param values buffer whose length is at least state_values()
+     * @see operator[]()
+     */
+    void get_state(float_t values[]) const {
+      for(unsigned i(0), n(state_values()); i < n; ++i){values[i] = (*this)[i];}
+    }
+
+    /**
+     * Import all state values at once, and then recalculate the dependent values.
+     * The quaternions are assumed to be regularized, for example, exported by get_state().
+     *
+     * @param values state values whose length is state_values()
+     * @see operator[]()
+     */
+    void set_state(const float_t values[]){
+      for(unsigned i(0), n(state_values()); i < n; ++i){(*this)[i] = values[i];}
+      recalc(false);
+    }
     
     /**
      * Return the gravity due to the Earth's rotation as
@@ -416,7 +511,7 @@ class INS {
             q_e2n[3] * q_e2n[2] - q_e2n[1] * q_e2n[0], // -sin(lambda) * cos(phi) / 2
             0);
       centripetal_f *= (pow2(Earth::Omega_Earth) * (Earth::R_normal(phi) + h) * 2);
-      return (q_e2n.conj() * centripetal_f * q_e2n).vector();
+      return q_e2n.conj().rotate(centripetal_f);
     }
 
     /**
@@ -452,7 +547,7 @@ class INS {
     virtual void update(const vec3_t &accel, const vec3_t &gyro, const float_t &deltaT){
       
       //x̉^
-      vec3_t delta_v_2e_4n((q_n2b * accel * q_n2b.conj()).vector());
+      vec3_t delta_v_2e_4n(q_n2b.rotate(accel));
       delta_v_2e_4n += gravity_total();
       delta_v_2e_4n -= (omega_e2i_4n * 2 + omega_n2e_4n) * v_2e_4n;
       
@@ -545,6 +640,7 @@ class INS {
       float_t delta_psi_h(delta_psi / 2);
       quat_t delta_q(std::cos(delta_psi_h), 0, 0, std::sin(delta_psi_h));
       q_n2b = delta_q * q_n2b;
+      rotation_cache.update_n2b(q_n2b);
     }
 
     /**
@@ -572,6 +668,7 @@ class INS {
         quat_t delta_q(c_theta, 0, s_theta * std::cos(roll), -s_theta * std::sin(roll));
         q_n2b *= delta_q;
       }
+      rotation_cache.update_n2b(q_n2b);
     }
 
     /**
@@ -584,6 +681,7 @@ class INS {
       float_t delta_phi_h(delta_phi / 2);
       quat_t delta_q(std::cos(delta_phi_h), std::sin(delta_phi_h), 0, 0);
       q_n2b *= delta_q;
+      rotation_cache.update_n2b(q_n2b);
     }
 
     /**
@@ -0,0 +1,203 @@
+/*
+ *  INS_ConingSculling.h, header file to perform calculation of inertial navigation system
+ *  with coning and sculling compensation in two-speed (minor and major interval) structure.
+ *  Copyright (C) 2017 M.Naruoka (fenrir)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INS_CONING_SCULLING_H__
+#define __INS_CONING_SCULLING_H__
+
+/** @file
+ * @brief Inertial navigation system with coning and sculling compensation
+ *
+ */
+
+#include <cmath>
+
+#include "INS.h"
+
+template <class FloatT>
+struct INS_ConingSculling_Property {
+  /**
+   * Interval [s] of the major (navigation frame) update.
+   * Samples are accumulated as minor increments until the interval elapses.
+   * Zero (default) or negative values mean the major update at every sample.
+   */
+  FloatT major_interval;
+  INS_ConingSculling_Property() : major_interval(0) {}
+};
+
+/**
+ * @brief INS whose mechanization has two speeds
+ *
+ * Each sample is accumulated as increments of angle and velocity in the body frame
+ * (minor update), which include the second-order coning and sculling terms.
+ * When the major interval elapses, the accumulated increments are converted to
+ * a rotation vector and a specific force velocity change, and then
+ * attitude, velocity, and position are updated in the navigation frame (major update),
+ * where the quaternions are propagated with their exact exponentials.
+ * Until the major update, the navigation states are kept unchanged.
+ *
+ * @param PureINS Base INS class
+ * @see Savage, P. G., "Strapdown Inertial Navigation Integration Algorithm Design
+ * Part 1: Attitude Algorithms" and "Part 2: Velocity and Position Algorithms",
+ * Journal of Guidance, Control, and Dynamics, 1998.
+ */
+template <class PureINS = INS<> >
+class INS_ConingSculling
+    : public PureINS,
+      protected INS_ConingSculling_Property<typename PureINS::float_t> {
+  public:
+    typedef PureINS super_t;
+#if defined(__GNUC__) && (__GNUC__ < 5)
+    typedef typename super_t::float_t float_t;
+    typedef typename super_t::vec3_t vec3_t;
+    typedef typename super_t::quat_t quat_t;
+#else
+    using typename super_t::float_t;
+    using typename super_t::vec3_t;
+    using typename super_t::quat_t;
+#endif
+    typedef INS_ConingSculling_Property<float_t> prop_t;
+
+  protected:
+    struct increment_t {
+      vec3_t alpha; ///< sum of angle increments @f$ \alpha = \sum \Delta \theta_{i} @f$
+      vec3_t beta; ///< coning term @f$ \beta @f$
+      vec3_t upsilon; ///< sum of velocity increments @f$ \upsilon = \sum \Delta v_{i} @f$
+      vec3_t sculling; ///< sculling term
+      vec3_t delta_theta; ///< previous angle increment
+      vec3_t delta_v; ///< previous velocity increment
+      float_t deltaT; ///< sum of intervals
+      increment_t()
+          : alpha(), beta(), upsilon(), sculling(),
+          delta_theta(), delta_v(), deltaT(0) {}
+      increment_t(const increment_t &orig, const bool &deepcopy = false)
+          : alpha(deepcopy ? orig.alpha.copy() : orig.alpha),
+          beta(deepcopy ? orig.beta.copy() : orig.beta),
+          upsilon(deepcopy ? orig.upsilon.copy() : orig.upsilon),
+          sculling(deepcopy ? orig.sculling.copy() : orig.sculling),
+          delta_theta(deepcopy ? orig.delta_theta.copy() : orig.delta_theta),
+          delta_v(deepcopy ? orig.delta_v.copy() : orig.delta_v),
+          deltaT(orig.deltaT) {}
+      /**
+       * Add increments of a sample with the recursive form of the second-order algorithms.
+       *
+       * @param accel acceleration (specific force) in the body frame
+       * @param gyro angular speed in the body frame
+       * @param dt interval
+       */
+      void add(const vec3_t &accel, const vec3_t &gyro, const float_t &dt){
+        vec3_t dtheta(gyro * dt), dv(accel * dt);
+        vec3_t alpha_dash(alpha + delta_theta / 6), upsilon_dash(upsilon + delta_v / 6);
+        beta += (alpha_dash * dtheta) / 2;
+        sculling += (alpha_dash * dv + upsilon_dash * dtheta) / 2;
+        alpha += dtheta;
+        upsilon += dv;
+        delta_theta = dtheta;
+        delta_v = dv;
+        deltaT += dt;
+      }
+    } increment;
+
+    /**
+     * Quaternion corresponding to a rotation vector @f$ \vec{x} @f$, i.e.,
+     * @f$ \exp(\vec{x} / 2) = \begin{Bmatrix} \cos(|x| / 2) \\ \sin(|x| / 2) \vec{x} / |x| \end{Bmatrix} @f$
+     */
+    static quat_t rotation(const vec3_t &x){
+      float_t x2(x.abs2());
+      if(x2 < 1E-12){ // series expansion
+        return quat_t(float_t(1) - x2 / 8, x * (float_t(0.5) - x2 / 48));
+      }
+      float_t x_abs(std::sqrt(x2));
+      return quat_t(std::cos(x_abs / 2), x * (std::sin(x_abs / 2) / x_abs));
+    }
+
+  public:
+    INS_ConingSculling() : super_t(), prop_t(), increment() {}
+
+    /**
+     * Copy constructor
+     *
+     * @param orig source
+     * @param deepcopy if true, perform deep copy
+     */
+    INS_ConingSculling(const INS_ConingSculling &orig, const bool &deepcopy = false)
+        : super_t(orig, deepcopy), prop_t(orig), increment(orig.increment, deepcopy) {}
+
+    virtual ~INS_ConingSculling(){}
+
+    void setup_coning_sculling(const prop_t &property){
+      prop_t::operator=(property);
+    }
+
+    /**
+     * Perform the major update with the accumulated increments.
+     * It is invoked automatically when the major interval elapses.
+     */
+    void update_major(){
+      if(increment.deltaT <= 0){return;}
+      const float_t &T(increment.deltaT);
+
+      // rotation vector of the body frame, and rotation of the navigation frame
+      vec3_t phi(increment.alpha + increment.beta);
+      vec3_t zeta((super_t::omega_e2i_4n + super_t::omega_n2e_4n) * T);
+
+      // velocity change due to specific force, which includes rotation compensation
+      vec3_t delta_v_4b(increment.upsilon + (increment.alpha * increment.upsilon) / 2);
+      delta_v_4b += increment.sculling;
+      vec3_t delta_v_4n(super_t::q_n2b.rotate(delta_v_4b));
+      delta_v_4n -= (zeta * delta_v_4n) / 2;
+
+      // velocity change due to gravity and Coriolis
+      vec3_t delta_v_g(super_t::gravity_total());
+      delta_v_g -= (super_t::omega_e2i_4n * 2 + super_t::omega_n2e_4n) * super_t::v_2e_4n;
+      delta_v_g *= T;
+
+      // position with the transport rate before the update, and the mean vertical velocity
+      float_t v_d(super_t::v_2e_4n[2]);
+      quat_t q_e2n(super_t::q_e2n * rotation(super_t::omega_n2e_4n * T));
+
+      // update
+      super_t::v_2e_4n += delta_v_4n;
+      super_t::v_2e_4n += delta_v_g;
+      super_t::q_e2n = q_e2n;
+      super_t::h -= (v_d + super_t::v_2e_4n[2]) / 2 * T;
+      super_t::q_n2b = rotation(-zeta) * super_t::q_n2b * rotation(phi);
+
+      { // the latest minor increments are kept for the next major interval
+        increment_t next;
+        next.delta_theta = increment.delta_theta;
+        next.delta_v = increment.delta_v;
+        increment = next;
+      }
+      super_t::recalc();
+    }
+
+    /**
+     * Minor update, which performs the major update when the major interval elapses.
+     *
+     * @param accel acceleration
+     * @param gyro angular speed
+     * @param deltaT interval time
+     */
+    virtual void update(const vec3_t &accel, const vec3_t &gyro, const float_t &deltaT){
+      increment.add(accel, gyro, deltaT);
+      if(increment.deltaT >= prop_t::major_interval){update_major();}
+    }
+};
+
+#endif /* __INS_CONING_SCULLING_H__ */
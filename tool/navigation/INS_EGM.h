@@ -47,12 +47,18 @@ class INS_EGM : public PureINS {
     using typename super_t::float_t;
     using typename super_t::vec3_t;
 #endif
+
+  protected:
+    mutable EGM_GravityCache<EGM> gravity_cache;
+
   public:
     /**
      * Constructor
-     *
+     * Gravity is reused while the position stays within 100 [m],
+     * whose error is far below the accelerometer resolution.
+     * @see set_gravity_cache_tolerance()
      */
-    INS_EGM() : super_t() {}
+    INS_EGM() : super_t(), gravity_cache(100) {}
 
     /**
      * Copy constructor
@@ -61,7 +67,7 @@ class INS_EGM : public PureINS {
      * @param deepcopy if true, perform deep copy
      */
     INS_EGM(const INS_EGM &orig, const bool &deepcopy = false)
-        : super_t(orig, deepcopy){
+        : super_t(orig, deepcopy), gravity_cache(orig.gravity_cache){
 
     }
 
@@ -71,6 +77,16 @@ class INS_EGM : public PureINS {
      */
     virtual ~INS_EGM(){}
 
+    /**
+     * Set tolerance of the position to reuse previously calculated gravity.
+     *
+     * @param tolerance [m]; zero disables the reuse, i.e., gravity is calculated at every call.
+     */
+    void set_gravity_cache_tolerance(const float_t &tolerance){
+      gravity_cache.tolerance = tolerance;
+      gravity_cache.invalidate();
+    }
+
     /**
      * Return the total gravity vector in accordance to current position.
      * The total gravity is derivative of the Earth's total potential,
@@ -81,7 +97,7 @@ class INS_EGM : public PureINS {
     virtual vec3_t gravity_total() const {
       typename super_t::Earth::xz_t xz(super_t::Earth::xz(super_t::phi, super_t::h));
       float_t phi_gc(xz.geocentric_latitude()), r(xz.distance());
-      typename EGM::gravity_res_t g(EGM::gravity(r, phi_gc, super_t::lambda));
+      typename EGM::gravity_res_t g(gravity_cache.gravity(r, phi_gc, super_t::lambda));
 
       /* gravity_res_t is in a local frame, whose -Z direction points to the center,
        * and whose X axis is parallel to meridian.
@@ -90,7 +106,7 @@ class INS_EGM : public PureINS {
        */
       float_t delta_phi(super_t::phi - phi_gc);
       float_t cp(std::cos(delta_phi)), sp(std::sin(delta_phi));
-      float_t ca(std::cos(super_t::alpha)), sa(std::sin(super_t::alpha));
+      const float_t &ca(super_t::rotation_cache.cos_alpha), &sa(super_t::rotation_cache.sin_alpha);
 
       vec3_t res(
           (g.phi *  ca * cp) + (g.lambda * sa) + (-g.r *  ca * sp),
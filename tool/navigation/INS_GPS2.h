@@ -138,6 +138,8 @@ class INS_GPS2 : public BaseFINS{
       using std::cos;
       using std::sin;
       float_t azimuth(BaseFINS::azimuth());
+      const float_t &c_alpha(BaseFINS::rotation_cache.cos_alpha);
+      const float_t &s_alpha(BaseFINS::rotation_cache.sin_alpha);
       
       //cout << "__correct__" << endl;
       
@@ -149,8 +151,8 @@ class INS_GPS2 : public BaseFINS{
       float_t z_serialized[8][1];
 #define z(i, j) z_serialized[i][j]
       {
-        z(0, 0) = get(0) - (gps.v_n * cos(azimuth) + gps.v_e * sin(azimuth));
-        z(1, 0) = get(1) - (gps.v_n * -sin(azimuth) + gps.v_e * cos(azimuth));
+        z(0, 0) = get(0) - (gps.v_n * c_alpha + gps.v_e * s_alpha);
+        z(1, 0) = get(1) - (gps.v_n * -s_alpha + gps.v_e * c_alpha);
         z(2, 0) = get(2) - gps.v_d;
         z(3, 0) = get(3) - q_e2n_gps[0];
         z(4, 0) = get(4) - q_e2n_gps[1];
@@ -250,13 +252,14 @@ class INS_GPS2 : public BaseFINS{
         const vec3_t &omega_b2i_4b) const {
                    
       float_t azimuth(BaseFINS::azimuth());
+      const float_t &c_alpha(BaseFINS::rotation_cache.cos_alpha);
+      const float_t &s_alpha(BaseFINS::rotation_cache.sin_alpha);
       
       // ʒu֌W
-      vec3_t lever_arm_n(
-        ((BaseFINS::q_n2b) * lever_arm_b * (BaseFINS::q_n2b).conj()).vector());
+      vec3_t lever_arm_n(BaseFINS::q_n2b.rotate(lever_arm_b));
       vec3_t lever_arm_g(
-          lever_arm_n[0] * cos(azimuth) - lever_arm_n[1] * sin(azimuth),
-          lever_arm_n[0] * sin(azimuth) + lever_arm_n[1] * cos(azimuth),
+          lever_arm_n[0] * c_alpha - lever_arm_n[1] * s_alpha,
+          lever_arm_n[0] * s_alpha + lever_arm_n[1] * c_alpha,
           lever_arm_n[2]
         );
       float_t lever_lat(-BaseFINS::meter2lat(lever_arm_g[0]));
@@ -282,9 +285,6 @@ class INS_GPS2 : public BaseFINS{
       }
       coefficient_pos_phi_lambda /= (std::sqrt(2.0) * 2);
       
-      float_t c_alpha(cos(azimuth));
-      float_t s_alpha(sin(azimuth));
-      
       mat_t coefficient_pos_lever_g(2, 3);
       {
         coefficient_pos_lever_g(0, 0) = BaseFINS::meter2lat(s_alpha * lever_arm_n[2] * -2);
@@ -304,10 +304,7 @@ class INS_GPS2 : public BaseFINS{
       vec3_t omega_b2n_4b(
           omega_b2i_4b - BaseFINS::omega_e2i_4n + BaseFINS::omega_n2e_4n
         );
-      vec3_t v_induced(
-        ((BaseFINS::q_n2b)
-          * (omega_b2n_4b * lever_arm_b) 
-          * (BaseFINS::q_n2b).conj()).vector());
+      vec3_t v_induced(BaseFINS::q_n2b.rotate(omega_b2n_4b * lever_arm_b));
       
       //mat_t coefficient_vel_omega(omega_b2n_4n.skewMatrix());
       //mat_t coefficient_vel_lever(-lever_arm_n.skewMatrix());
@@ -317,9 +314,9 @@ class INS_GPS2 : public BaseFINS{
 #define z(i, j) z_serialized[i][j]
       {
         z(0, 0) = get(0) 
-            - ((gps.v_n * cos(azimuth) + gps.v_e * sin(azimuth)) - v_induced[0]);
+            - ((gps.v_n * c_alpha + gps.v_e * s_alpha) - v_induced[0]);
         z(1, 0) = get(1) 
-            - ((gps.v_n * -sin(azimuth) + gps.v_e * cos(azimuth)) - v_induced[1]);
+            - ((gps.v_n * -s_alpha + gps.v_e * c_alpha) - v_induced[1]);
         z(2, 0) = get(2) 
             - (gps.v_d - v_induced[2]);
         z(3, 0) = get(3) - q_e2n_gps[0];
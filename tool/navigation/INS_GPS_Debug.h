@@ -157,10 +157,9 @@ class INS_GPS_Debug_Covariance : public INS_GPS_Debug<INS_GPS> {
       inspect_matrix(out, mat);
     }
     void inspect(std::ostream &out) const {
-      typedef INS_GPS_Debug_Covariance<INS_GPS> self_t;
       switch(super_t::debug_target){
         case super_t::DEBUG_KF_P:
-          inspect_matrix(out, const_cast<self_t *>(this)->getFilter().getP());
+          inspect_matrix(out, this->getFilter_unpropagated().getP());
           break;
         case super_t::DEBUG_KF_FULL:
           switch(last_action){
@@ -177,19 +176,19 @@ class INS_GPS_Debug_Covariance : public INS_GPS_Debug<INS_GPS> {
               inspect_matrix2(out, snapshot.v, "v");
               break;
           }
-          inspect_matrix2(out, const_cast<self_t *>(this)->getFilter().getP(), "P");
+          inspect_matrix2(out, this->getFilter_unpropagated().getP(), "P");
           break;
       }
     }
 
   protected:
     void before_update_INS(
-        const mat_t &A, const mat_t &B,
+        const typename INS_GPS::getAB_res &AB,
         const float_t &elapsedT){
       last_action = ACTION_LAST_UPDATE;
-      snapshot.A = A;
-      snapshot.B = B;
-      super_t::before_update_INS(A, B, elapsedT);
+      snapshot.A = AB.getA();
+      snapshot.B = AB.getB();
+      super_t::before_update_INS(AB, elapsedT);
     }
 
     void before_correct_INS(
@@ -22,6 +22,7 @@ navigation algorithm.
 
 #include "INS.h"
 #include "INS_EGM.h"
+#include "INS_ConingSculling.h"
 #include "Filtered_INS2.h"
 #include "INS_GPS2.h"
 #include "BiasEstimation.h"
@@ -46,6 +47,7 @@ struct INS_GPS_Factory_Options {
 
   enum {
     Priority_EGM,
+    Priority_ConingSculling,
     Priority_KF,
     Priority_Bias,
   };
@@ -118,6 +120,40 @@ struct INS_GPS_Factory_Options {
     };
   };
 
+  // INS with coning and sculling compensation
+  template <class T>
+  struct coning_sculling_t : option_t<T> {
+
+    static const int priority = Priority_ConingSculling;
+
+    template <class T_Change>
+    struct change_t {
+      typedef coning_sculling_t<T_Change> res_t;
+    };
+
+    template <class T_Add>
+    struct add_t {
+      template <class T_Rebuild>
+      struct check_copy_t {
+        template <bool new_is_under, class U = void>
+        struct check_order_t { // new_opt<old_opt>
+          typedef typename T_Rebuild::template change_t<coning_sculling_t<T> >::res_t res_t;
+        };
+        template <class U>
+        struct check_order_t<true, U> { // old_opt_top<new_opt>
+          typedef coning_sculling_t<T_Rebuild> res_t;
+        };
+        typedef typename check_order_t<(priority > T_Rebuild::priority)>::res_t res_t;
+      };
+      template <class T_Rebuild_Base>
+      struct check_copy_t<coning_sculling_t<T_Rebuild_Base> > {
+        typedef coning_sculling_t<T_Rebuild_Base> res_t;
+      };
+      typedef typename check_copy_t<
+          typename option_t<T>::template add_t<T_Add>::res_t>::res_t res_t;
+    };
+  };
+
   // bias estimation
   template <class T>
   struct bias_t : option_t<T> {
@@ -218,6 +254,17 @@ struct INS_GPS_Factory {
         ::template add_t<
           typename INS_GPS_Factory_Options::template egm_t<void, EGM> >::res_t> {};
 
+  // INS with coning and sculling compensation
+  template <class T>
+  struct option_t<typename INS_GPS_Factory_Options::coning_sculling_t<T> > : option_t<T> {
+    typedef INS_ConingSculling<typename option_t<T>::ins_t> ins_t;
+  };
+  template <class U = void>
+  struct coning_sculling : public INS_GPS_Factory<PureINS,
+      typename INS_GPS_Factory_Options::template option_t<Options>
+        ::template add_t<
+          typename INS_GPS_Factory_Options::template coning_sculling_t<void> >::res_t> {};
+
   // bias estimation
   template <class T>
   struct option_t<typename INS_GPS_Factory_Options::bias_t<T> > : option_t<T> {
@@ -23,7 +23,169 @@
 #include "param/matrix.h"
 #include "param/vector3.h"
 
-#include <list>
+#include <vector>
+#include <deque>
+#include <cstddef>
+
+/**
+ * @brief Circular buffer of snapshots
+ *
+ * Elements are recycled in place; therefore, matrices in the elements are allocated
+ * only at their first use, and the capacity is doubled only when the buffer is full.
+ * Index 0 means the oldest element.
+ *
+ * @param T type of element, which has a copy constructor with the deepcopy flag
+ */
+template <class T>
+class INS_GPS_Snapshot_Buffer {
+  protected:
+    std::vector<T> buf;
+    unsigned int head, count;
+
+    void grow(){
+      const unsigned int capacity_new(buf.empty() ? 1 : (buf.size() * 2));
+      std::vector<T> buf_new;
+      buf_new.reserve(capacity_new);
+      for(unsigned int i(0); i < count; ++i){
+        buf_new.push_back(T((*this)[i])); // shared, because the old buffer is discarded
+      }
+      buf_new.resize(capacity_new);
+      buf.swap(buf_new);
+      head = 0;
+    }
+  public:
+    INS_GPS_Snapshot_Buffer(const unsigned int &capacity = 0x100)
+        : buf(capacity), head(0), count(0) {}
+    INS_GPS_Snapshot_Buffer(
+        const INS_GPS_Snapshot_Buffer &orig,
+        const bool &deepcopy = false)
+        : buf(), head(0), count(orig.count) {
+      buf.reserve(orig.buf.size());
+      for(unsigned int i(0); i < orig.buf.size(); ++i){
+        buf.push_back(T(orig[i], deepcopy));
+      }
+    }
+
+    unsigned int size() const {return count;}
+    bool empty() const {return count == 0;}
+    unsigned int capacity() const {return buf.size();}
+
+    T &operator[](const unsigned int &index){
+      return buf[(head + index) % buf.size()];
+    }
+    const T &operator[](const unsigned int &index) const {
+      return buf[(head + index) % buf.size()];
+    }
+    T &front(){return (*this)[0];}
+    const T &front() const {return (*this)[0];}
+    T &back(){return (*this)[count - 1];}
+    const T &back() const {return (*this)[count - 1];}
+
+    /**
+     * Append an element. Its content is left as it was used previously,
+     * and should be overwritten by the caller.
+     *
+     * @return (T &) the appended element
+     */
+    T &push_back(){
+      if(count == buf.size()){grow();}
+      ++count;
+      return back();
+    }
+    /**
+     * Remove the oldest elements
+     *
+     * @param n number of elements to be removed
+     */
+    void pop_front(unsigned int n = 1){
+      if(n > count){n = count;}
+      if(n == 0){return;}
+      head = (head + n) % buf.size();
+      count -= n;
+    }
+    void pop_back(){
+      if(count > 0){--count;}
+    }
+};
+
+/**
+ * @brief Common content of snapshots, i.e., navigation states exported by INS::get_state()
+ * and the input noise @f$ \Gamma Q \Gamma^{T} @f$ of the time update.
+ */
+template <class INS_GPS>
+struct INS_GPS_Snapshot_Content {
+  typedef typename INS_GPS::float_t float_t;
+  typedef typename INS_GPS::mat_t mat_t;
+
+  float_t state[INS_GPS::STATE_VALUES];
+  mat_t GQGt;
+
+  INS_GPS_Snapshot_Content() : GQGt() {}
+  INS_GPS_Snapshot_Content(
+      const INS_GPS_Snapshot_Content &orig,
+      const bool &deepcopy = false)
+      : GQGt(deepcopy ? orig.GQGt.copy() : orig.GQGt) {
+    for(unsigned int i(0); i < INS_GPS::STATE_VALUES; ++i){state[i] = orig.state[i];}
+  }
+
+  /**
+   * Overwrite a matrix with another one, where storage is allocated only when the size differs.
+   */
+  static void overwrite(mat_t &dst, const mat_t &src){
+    if(dst.isDifferentSize(src)){
+      dst = src.copy();
+    }else{
+      dst.replace(src, false);
+    }
+  }
+  /**
+   * Overwrite a matrix with a two-dimensional array.
+   *
+   * @param sign multiplied to each element
+   */
+  template <class T, std::size_t Rows, std::size_t Columns>
+  static void overwrite(mat_t &dst, const T (&src)[Rows][Columns], const T &sign = T(1)){
+    if((dst.rows() != Rows) || (dst.columns() != Columns)){
+      dst = mat_t(Rows, Columns);
+    }
+    for(unsigned int i(0); i < Rows; ++i){
+      for(unsigned int j(0); j < Columns; ++j){
+        dst(i, j) = src[i][j] * sign;
+      }
+    }
+  }
+
+  /**
+   * Store @f$ \Gamma Q \Gamma^{T} @f$ without temporary matrices.
+   *
+   * @param AB matrices of the time update, whose @f$ \Gamma @f$ has been already computed
+   * @param Q covariance of the input noise
+   */
+  template <class AB_T>
+  void set_GQGt(const AB_T &AB, const mat_t &Q){
+    static const unsigned int P_SIZE(sizeof(AB.Gamma) / sizeof(AB.Gamma[0]));
+    static const unsigned int Q_SIZE(sizeof(AB.Gamma[0]) / sizeof(AB.Gamma[0][0]));
+    if((GQGt.rows() != P_SIZE) || (GQGt.columns() != P_SIZE)){
+      GQGt = mat_t(P_SIZE, P_SIZE);
+    }
+    float_t GQ[Q_SIZE];
+    for(unsigned int i(0); i < P_SIZE; ++i){
+      for(unsigned int j(0); j < Q_SIZE; ++j){
+        GQ[j] = 0;
+        for(unsigned int k(0); k < Q_SIZE; ++k){
+          GQ[j] += AB.Gamma[i][k] * Q(k, j);
+        }
+      }
+      for(unsigned int j(0); j <= i; ++j){
+        float_t v(0);
+        for(unsigned int k(0); k < Q_SIZE; ++k){
+          v += GQ[k] * AB.Gamma[j][k];
+        }
+        GQGt(i, j) = GQGt(j, i) = v;
+      }
+    }
+  }
+};
 
 template <class FloatT>
 struct INS_GPS_Back_Propagate_Property {
@@ -46,62 +208,89 @@ class INS_GPS_Back_Propagate : public INS_GPS, protected INS_GPS_Back_Propagate_
     using typename INS_GPS::mat_t;
 #endif
   public:
-    struct snapshot_content_t {
-      INS_GPS ins_gps;
+    /**
+     * Snapshot, which holds the minimal content for back propagation,
+     * i.e., navigation states and their covariance P, not the whole INS_GPS object.
+     */
+    struct snapshot_content_t : public INS_GPS_Snapshot_Content<INS_GPS> {
+      typedef INS_GPS_Snapshot_Content<INS_GPS> super_t;
+      mat_t P;
       mat_t Phi;
-      mat_t GQGt;
       float_t elapsedT_from_last_correct;
+      snapshot_content_t()
+          : super_t(), P(), Phi(), elapsedT_from_last_correct(0) {}
       snapshot_content_t(
-          const INS_GPS &_ins_gps,
-          const mat_t &_Phi,
-          const mat_t &_GQGt,
-          const float_t &_elapsedT)
-          : ins_gps(_ins_gps, true), Phi(_Phi), GQGt(_GQGt),
-          elapsedT_from_last_correct(_elapsedT){
+          const snapshot_content_t &orig,
+          const bool &deepcopy = false)
+          : super_t(orig, deepcopy),
+          P(deepcopy ? orig.P.copy() : orig.P),
+          Phi(deepcopy ? orig.Phi.copy() : orig.Phi),
+          elapsedT_from_last_correct(orig.elapsedT_from_last_correct){
+      }
+      /**
+       * Write back the content to an INS_GPS object
+       */
+      void restore(INS_GPS &ins_gps) const {
+        ins_gps.set_state(super_t::state);
+        ins_gps.getFilter().setP(P);
       }
     };
-    typedef std::list<snapshot_content_t> snapshots_t;
+    typedef INS_GPS_Snapshot_Buffer<snapshot_content_t> snapshots_t;
     typedef INS_GPS_Back_Propagate_Property<float_t> prop_t;
   protected:
     snapshots_t snapshots;
+    mutable std::deque<INS_GPS> restored; ///< objects reused by restore_snapshot()
   public:
     INS_GPS_Back_Propagate()
-        : INS_GPS(), snapshots(), prop_t() {}
+        : INS_GPS(), prop_t(), snapshots(), restored() {}
     INS_GPS_Back_Propagate(
         const INS_GPS_Back_Propagate &orig,
         const bool &deepcopy = false)
-        : INS_GPS(orig, deepcopy), snapshots(orig.snapshots),
-        prop_t(orig) {}
+        : INS_GPS(orig, deepcopy), prop_t(orig),
+        snapshots(orig.snapshots, deepcopy), restored() {}
     virtual ~INS_GPS_Back_Propagate(){}
     void setup_back_propagation(const prop_t &property){
       prop_t::operator=(property);
     }
     const snapshots_t &get_snapshots() const {return snapshots;}
 
+    /**
+     * Restore an INS_GPS object from a snapshot, for example, to output it.
+     * The returned object is reused by the next call with the same index.
+     *
+     * @param index index of snapshots, where 0 is the oldest
+     * @return (const INS_GPS &) restored object
+     */
+    const INS_GPS &restore_snapshot(const unsigned int &index) const {
+      while(restored.size() <= index){
+        restored.push_back(INS_GPS(*this, true));
+      }
+      snapshots[index].restore(restored[index]);
+      return restored[index];
+    }
+
   protected:
     /**
      * Call-back function for time update
      *
-     * @param A matrix A
-     * @param B matrix B
+     * @param AB matrices A and B
      * @patam elapsedT interval time
      */
     void before_update_INS(
-        const mat_t &A, const mat_t &B,
+        const typename INS_GPS::getAB_res &AB,
         const float_t &elapsedT){
-      mat_t Phi(A * elapsedT);
-      for(unsigned i(0); i < A.rows(); i++){Phi(i, i) += 1;}
-      mat_t Gamma(B * elapsedT);
 
       float_t elapsedT_from_last_correct(elapsedT);
       if(!snapshots.empty()){
         elapsedT_from_last_correct += snapshots.back().elapsedT_from_last_correct;
       }
 
-      snapshots.push_back(
-          snapshot_content_t(*this,
-              Phi, Gamma * INS_GPS::getFilter().getQ() * Gamma.transpose(),
-              elapsedT_from_last_correct));
+      snapshot_content_t &snapshot(snapshots.push_back());
+      INS_GPS::get_state(snapshot.state);
+      snapshot_content_t::overwrite(snapshot.P, INS_GPS::getFilter().getP());
+      snapshot_content_t::overwrite(snapshot.Phi, AB.Phi);
+      snapshot.set_GQGt(AB, INS_GPS::getFilter().getQ());
+      snapshot.elapsedT_from_last_correct = elapsedT_from_last_correct;
     }
 
     /**
@@ -127,33 +316,36 @@ class INS_GPS_Back_Propagate : public INS_GPS, protected INS_GPS_Back_Propagate_
         if(mod_elapsedT > 0){
 
           // The latest is the first
-          for(typename snapshots_t::reverse_iterator it(snapshots.rbegin());
-              it != snapshots.rend();
-              ++it){
+          for(unsigned int i(snapshots.size()); i-- > 0; ){
+            snapshot_content_t &snapshot(snapshots[i]);
             // This statement controls depth of back propagation.
-            if(it->elapsedT_from_last_correct
+            if(snapshot.elapsedT_from_last_correct
                 < prop_t::back_propagate_depth){
               if(mod_elapsedT > 0.1){ // Skip only when sufficient amount of snapshots are existed.
-                snapshots.erase(snapshots.begin(), it.base());
+                snapshots.pop_front(i + 1);
                 //cerr << "[erase]" << endl;
                 if(snapshots.empty()){return;}
               }
               break;
             }
             // Positive value stands for states to which applied back-propagation have not been applied
-            it->elapsedT_from_last_correct -= mod_elapsedT;
+            snapshot.elapsedT_from_last_correct -= mod_elapsedT;
           }
         }
 
-        snapshot_content_t previous(snapshots.back());
-        snapshots.pop_back();
+        snapshot_content_t &previous(snapshots.back());
 
-        // Perform back-propagation
+        // Perform back-propagation with a temporary object,
+        // which is created per correction, not per time update.
+        INS_GPS ins_gps(*this, true);
+        ins_gps.set_state(previous.state);
+        ins_gps.getFilter().setP(previous.P.copy());
         mat_t H_dash(H * previous.Phi);
         mat_t R_dash(R + H * previous.GQGt * H.transpose());
-        previous.ins_gps.correct_primitive(H_dash, v, R_dash);
+        ins_gps.correct_primitive(H_dash, v, R_dash);
 
-        snapshots.push_back(previous);
+        ins_gps.get_state(previous.state);
+        snapshot_content_t::overwrite(previous.P, ins_gps.getFilter().getP());
       }
     }
 };
@@ -178,32 +370,48 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
 #endif
     typedef INS_GPS_RealTime_Property<float_t> prop_t;
   protected:
-    struct snapshot_content_t {
-      INS_GPS ins_gps;
+    /**
+     * Snapshot, which holds navigation states for correct_info(), and
+     * either A (RT_LIGHT_WEIGHT) or @f$ \Phi^{-1} @f$ (RT_NORMAL) in accordance with the mode.
+     */
+    struct snapshot_content_t : public INS_GPS_Snapshot_Content<INS_GPS> {
+      typedef INS_GPS_Snapshot_Content<INS_GPS> super_t;
       mat_t A;
       mat_t Phi_inv;
-      mat_t GQGt;
       float_t elapsedT_from_last_update;
+      snapshot_content_t()
+          : super_t(), A(), Phi_inv(), elapsedT_from_last_update(0) {}
       snapshot_content_t(
-          const INS_GPS &_ins_gps,
-          const mat_t &_A,
-          const mat_t &_Phi_inv,
-          const mat_t &_GQGt,
-          const float_t &_elapsedT)
-          : ins_gps(_ins_gps, true),
-          A(_A), Phi_inv(_Phi_inv), GQGt(_GQGt),
-          elapsedT_from_last_update(_elapsedT){
+          const snapshot_content_t &orig,
+          const bool &deepcopy = false)
+          : super_t(orig, deepcopy),
+          A(deepcopy ? orig.A.copy() : orig.A),
+          Phi_inv(deepcopy ? orig.Phi_inv.copy() : orig.Phi_inv),
+          elapsedT_from_last_update(orig.elapsedT_from_last_update){
       }
     };
-    typedef std::list<snapshot_content_t> snapshots_t;
+    typedef INS_GPS_Snapshot_Buffer<snapshot_content_t> snapshots_t;
     snapshots_t snapshots;
+    std::deque<INS_GPS> restored; ///< object reused by restore_front()
+
+    /**
+     * Restore an INS_GPS object from the oldest snapshot.
+     * The returned object is reused by the next call.
+     */
+    INS_GPS &restore_front(){
+      if(restored.empty()){
+        restored.push_back(INS_GPS(*this, true));
+      }
+      restored.front().set_state(snapshots.front().state);
+      return restored.front();
+    }
   public:
     INS_GPS_RealTime()
-        : INS_GPS(), snapshots() {}
+        : INS_GPS(), snapshots(), restored() {}
     INS_GPS_RealTime(
         const INS_GPS_RealTime &orig,
         const bool &deepcopy = false)
-        : INS_GPS(orig, deepcopy), snapshots(orig.snapshots){}
+        : INS_GPS(orig, deepcopy), snapshots(orig.snapshots, deepcopy), restored(){}
     virtual ~INS_GPS_RealTime(){}
     void setup_realtime(const prop_t &property){
       prop_t::operator=(property);
@@ -213,21 +421,28 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
     /**
      * Call-back function for time update
      *
-     * @param A matrix A
-     * @param B matrix B
+     * @param AB matrices A and B
      * @patam elapsedT interval time
      */
     void before_update_INS(
-        const mat_t &A, const mat_t &B,
+        const typename INS_GPS::getAB_res &AB,
         const float_t &elapsedT){
-      mat_t Phi(A * elapsedT);
-      for(unsigned i(0); i < A.rows(); i++){Phi(i, i) += 1;}
-      mat_t Gamma(B * elapsedT);
-
-      snapshots.push_back(
-          snapshot_content_t(*this,
-              A, Phi.inverse(), Gamma * INS_GPS::getFilter().getQ() * Gamma.transpose(),
-              elapsedT));
+      snapshot_content_t &snapshot(snapshots.push_back());
+      INS_GPS::get_state(snapshot.state);
+      switch(prop_t::rt_mode){
+        case prop_t::RT_LIGHT_WEIGHT:
+          snapshot_content_t::overwrite(snapshot.A, AB.A);
+          break;
+        case prop_t::RT_NORMAL:
+        default:
+          // @f$ \Phi^{-1} \approx I - A \Delta t @f$, the same as getAB_res::getPhi_inv()
+          snapshot_content_t::overwrite(snapshot.Phi_inv, AB.A, -AB.deltaT);
+          for(unsigned int i(0); i < snapshot.Phi_inv.rows(); ++i){
+            snapshot.Phi_inv(i, i) += 1;
+          }
+      }
+      snapshot.set_GQGt(AB, INS_GPS::getFilter().getQ());
+      snapshot.elapsedT_from_last_update = elapsedT;
     }
 
   public:
@@ -241,16 +456,11 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
     bool setup_correct(float_t advanceT){
       if(advanceT > 0){return false;} // positive value (future) is odd
 
-      for(typename snapshots_t::reverse_iterator it(snapshots.rbegin());
-          it != snapshots.rend();
-          ++it){
-        advanceT += it->elapsedT_from_last_update;
+      for(unsigned int i(snapshots.size()); i-- > 0; ){
+        advanceT += snapshots[i].elapsedT_from_last_update;
         if(advanceT > -0.005){ // Find the closest
-          if(it == snapshots.rbegin()){
-            // Keep at least one snapshot
-            it++;
-          }
-          snapshots.erase(snapshots.begin(), it.base());
+          // Keep at least one snapshot
+          snapshots.pop_front((i + 1 == snapshots.size()) ? i : (i + 1));
           return true;
         }
       }
@@ -272,13 +482,11 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
             mat_t sum_A(H.columns(), H.columns());
             mat_t sum_GQGt(sum_A.rows(), sum_A.rows());
             float_t bar_delteT(0);
-            int n(0);
-            for(typename snapshots_t::iterator it(snapshots.begin());
-                it != snapshots.end();
-                ++it, ++n){
-              sum_A += it->A;
-              sum_GQGt += it->GQGt;
-              bar_delteT += it->elapsedT_from_last_update;
+            int n(snapshots.size());
+            for(unsigned int i(0); i < snapshots.size(); ++i){
+              sum_A += snapshots[i].A;
+              sum_GQGt += snapshots[i].GQGt;
+              bar_delteT += snapshots[i].elapsedT_from_last_update;
             }
             bar_delteT /= n;
             mat_t sum_A_GQGt(sum_A * sum_GQGt);
@@ -290,11 +498,9 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
           break;
         case prop_t::RT_NORMAL:
         default:
-          for(typename snapshots_t::iterator it(snapshots.begin());
-              it != snapshots.end();
-              ++it){
-            H *= it->Phi_inv;
-            R += H * it->GQGt * H.transpose();
+          for(unsigned int i(0); i < snapshots.size(); ++i){
+            H *= snapshots[i].Phi_inv;
+            R += H * snapshots[i].GQGt * H.transpose();
           }
       }
       INS_GPS::correct_primitive(info);
@@ -303,7 +509,7 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
   public:
     template <class GPS_Packet>
     void correct(const GPS_Packet &gps){
-      CorrectInfo<float_t> info(snapshots.front().ins_gps.correct_info(gps));
+      CorrectInfo<float_t> info(restore_front().correct_info(gps));
       correct_with_info(info);
     }
 
@@ -311,7 +517,7 @@ class INS_GPS_RealTime : public INS_GPS, protected INS_GPS_RealTime_Property<typ
     void correct(const GPS_Packet &gps,
         const vec3_t &lever_arm_b,
         const vec3_t &omega_b2i_4b){
-      CorrectInfo<float_t> info(snapshots.front().ins_gps.correct_info(gps, lever_arm_b, omega_b2i_4b));
+      CorrectInfo<float_t> info(restore_front().correct_info(gps, lever_arm_b, omega_b2i_4b));
       correct_with_info(info);
     }
 };
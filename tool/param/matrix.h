@@ -61,8 +61,19 @@
 #include <cfloat>
 #include <ostream>
 #include <limits>
+#include <new>
+#include <cstddef>
 #include "param/complex.h"
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MATRIX_USE_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MATRIX_USE_SSE2
+#endif
+
 #if (__cplusplus < 201103L) && !defined(noexcept)
 #define noexcept throw()
 #endif
@@ -78,6 +89,22 @@
 #define DELETE_IF_MSC(x) x
 #endif
 
+#if !defined(MATRIX_POOL_DISABLED) && !defined(MATRIX_POOL_THREAD_LOCAL)
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1900))
+#define MATRIX_POOL_THREAD_LOCAL thread_local
+#else
+#define MATRIX_POOL_DISABLED // pool is not thread-safe without thread local storage
+#endif
+#endif
+
+#if defined(MATRIX_ATOMIC_REFCOUNT)
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1900))
+#include <atomic>
+#else
+#error "MATRIX_ATOMIC_REFCOUNT requires std::atomic (C++11)"
+#endif
+#endif
+
 /**
  * @brief 2D array abstract class for fixed content
  *
@@ -211,6 +238,233 @@ class Array2D : public Array2D_Frozen<T> {
     virtual ImplementedT copy(const bool &is_deep = false) const = 0;
 };
 
+/**
+ * @brief Thread local pool of memory blocks classified by size
+ *
+ * Blocks up to max_size bytes are rounded up to power of two,
+ * and released blocks are kept in the free list of the current thread for reuse.
+ * Larger blocks are directly obtained from and returned to the global operator new/delete.
+ * A block may be released by a thread other than the allocator thread;
+ * then it is simply reused by the releasing thread.
+ */
+struct Array2D_Dense_Pool {
+  static const unsigned int min_size_bits = 6; ///< smallest class, 64 bytes
+  static const unsigned int classes = 11; ///< largest class, 64 KB
+  static const unsigned int max_size = (1u << (min_size_bits + classes - 1));
+
+  struct free_t {
+    free_t *next;
+  };
+  /**
+   * Free lists, which are trivially destructible and therefore still accessible
+   * after the thread local cleaner has run, for example, during destruction of static objects.
+   * Then, closed is set and the pool is bypassed.
+   */
+  struct lists_t {
+    free_t *head[classes];
+    bool closed;
+  };
+#if !defined(MATRIX_POOL_DISABLED)
+  struct cleaner_t {
+    lists_t &target;
+    cleaner_t(lists_t &lists) : target(lists) {}
+    ~cleaner_t() {
+      target.closed = true;
+      for(unsigned int i(0); i < classes; ++i){
+        while(target.head[i]){
+          free_t *next(target.head[i]->next);
+          ::operator delete(target.head[i]);
+          target.head[i] = next;
+        }
+      }
+    }
+  };
+  static lists_t *lists(){
+    static MATRIX_POOL_THREAD_LOCAL lists_t res = {{NULL}, false};
+    if(res.closed){return NULL;}
+    static MATRIX_POOL_THREAD_LOCAL cleaner_t cleaner(res);
+    return &res;
+  }
+#endif
+
+  /**
+   * @param size required bytes
+   * @return (unsigned int) size class, or classes when the block is not pooled
+   */
+  static unsigned int size_class(const std::size_t &size){
+#if !defined(MATRIX_POOL_DISABLED)
+    if(size <= max_size){
+      unsigned int res(0);
+      for(std::size_t capacity(1u << min_size_bits); capacity < size; capacity <<= 1){++res;}
+      return res;
+    }
+#endif
+    return classes;
+  }
+
+  static void *allocate(const std::size_t &size, const unsigned int &size_class){
+#if !defined(MATRIX_POOL_DISABLED)
+    lists_t *target;
+    if((size_class < classes) && (target = lists())){
+      free_t *&head(target->head[size_class]);
+      if(head){
+        void *res(head);
+        head = head->next;
+        return res;
+      }
+      return ::operator new(1u << (min_size_bits + size_class));
+    }
+#endif
+    return ::operator new(size);
+  }
+
+  static void deallocate(void *block, const unsigned int &size_class){
+#if !defined(MATRIX_POOL_DISABLED)
+    lists_t *target;
+    if((size_class < classes) && (target = lists())){
+      free_t *&head(target->head[size_class]);
+      free_t *released(static_cast<free_t *>(block));
+      released->next = head;
+      head = released;
+      return;
+    }
+#endif
+    ::operator delete(block);
+  }
+};
+
+/**
+ * @brief Storage allocator for Array2D_Dense
+ *
+ * Reference counter and elements are placed in a single block, which is obtained from
+ * Array2D_Dense_Pool. Another allocation strategy can be plugged in
+ * by specializing this class with the same interface.
+ *
+ * The reference counter is a plain integer by default, therefore,
+ * shallow copies sharing a block must be used in the same thread.
+ * When MATRIX_ATOMIC_REFCOUNT is defined, the counter is atomically updated,
+ * and shallow copies can be passed to other threads as long as nobody writes the elements,
+ * which can be ensured by copy-on-write enabled with MATRIX_COPY_ON_WRITE.
+ * Both are opt-in because they slow down single-threaded use.
+ *
+ * @param T precision, for example, double
+ */
+template <class T>
+struct Array2D_Dense_Allocator {
+#if defined(MATRIX_ATOMIC_REFCOUNT)
+  typedef std::atomic<int> counter_t;
+#else
+  typedef int counter_t;
+#endif
+  union header_t {
+    struct {
+      counter_t ref; ///< reference counter, which must be the first member
+      unsigned int size;
+      unsigned int size_class;
+    } prop;
+    long double align_ld;
+    void *align_ptr;
+  };
+
+  template <class T2, bool is_primitive = std::numeric_limits<T2>::is_specialized>
+  struct setup_t {
+    static void construct(T2 *values, const unsigned int &size){
+      unsigned int i(0);
+      try{
+        for(; i < size; ++i){new(&values[i]) T2();}
+      }catch(...){
+        destruct(values, i);
+        throw;
+      }
+    }
+    static void destruct(T2 *values, const unsigned int &size){
+      for(unsigned int i(0); i < size; ++i){values[i].~T2();}
+    }
+  };
+  template <class T2>
+  struct setup_t<T2, true> {
+    static void construct(T2 *values, const unsigned int &size){}
+    static void destruct(T2 *values, const unsigned int &size){}
+  };
+
+  /**
+   * Allocate reference counter, which is initialized with one, and elements
+   *
+   * @param size number of elements
+   * @param values pointer to the allocated elements
+   * @return (counter_t *) pointer to the reference counter
+   */
+  static counter_t *allocate(const unsigned int &size, T *&values){
+    std::size_t bytes(sizeof(header_t) + sizeof(T) * size);
+    unsigned int size_class(Array2D_Dense_Pool::size_class(bytes));
+    header_t *header(static_cast<header_t *>(Array2D_Dense_Pool::allocate(bytes, size_class)));
+    values = reinterpret_cast<T *>(header + 1);
+    try{
+      setup_t<T>::construct(values, size);
+    }catch(...){
+      Array2D_Dense_Pool::deallocate(header, size_class);
+      throw;
+    }
+    new(&(header->prop.ref)) counter_t(1);
+    header->prop.size = size;
+    header->prop.size_class = size_class;
+    return &(header->prop.ref);
+  }
+
+  /**
+   * Release block obtained by allocate()
+   *
+   * @param ref pointer to the reference counter
+   */
+  static void deallocate(counter_t *ref){
+    header_t *header(reinterpret_cast<header_t *>(ref));
+    setup_t<T>::destruct(reinterpret_cast<T *>(header + 1), header->prop.size);
+    Array2D_Dense_Pool::deallocate(header, header->prop.size_class);
+  }
+
+  /**
+   * Increase reference counter for a new holder of the block
+   *
+   * @param ref pointer to the reference counter
+   */
+  static void acquire(counter_t *ref){
+#if defined(MATRIX_ATOMIC_REFCOUNT)
+    ref->fetch_add(1, std::memory_order_relaxed);
+#else
+    ++(*ref);
+#endif
+  }
+
+  /**
+   * Decrease reference counter, and release the block when no holder remains
+   *
+   * @param ref pointer to the reference counter
+   */
+  static void release(counter_t *ref){
+#if defined(MATRIX_ATOMIC_REFCOUNT)
+    if(ref->fetch_sub(1, std::memory_order_acq_rel) > 1){return;}
+#else
+    if(--(*ref) > 0){return;}
+#endif
+    deallocate(ref);
+  }
+
+  /**
+   * @param ref pointer to the reference counter
+   * @return (bool) true when the block has other holders
+   */
+  static bool shared(const counter_t *ref){
+#if defined(MATRIX_ATOMIC_REFCOUNT)
+    return ref->load(std::memory_order_acquire) > 1;
+#else
+    return (*ref) > 1;
+#endif
+  }
+};
+
+template <class MatrixT>
+struct MatrixBuilder_ValueCopier;
+
 /**
  * @brief Array2D whose elements are dense, and are stored in sequential 1D array.
  * In other words, (i, j) element is mapped to [i * rows + j].
@@ -222,6 +476,9 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
   public:
     typedef Array2D_Dense<T> self_t;
     typedef Array2D<T, self_t> super_t;
+
+    template <class MatrixT>
+    friend struct MatrixBuilder_ValueCopier;
     
     template <class T2>
     struct family_t {
@@ -232,8 +489,16 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
     using super_t::columns;
 
   protected:
+    typedef Array2D_Dense_Allocator<T> allocator_t;
+    typedef typename allocator_t::counter_t counter_t;
     T *values; ///< array for values
-    int *ref;  ///< reference counter
+    counter_t *ref;  ///< reference counter
+#if defined(MATRIX_COPY_ON_WRITE)
+    struct copy_on_write_t {
+      bool enabled; ///< if true, detach shared storage before write access
+      copy_on_write_t() : enabled(false) {}
+    } cow;
+#endif
 
     template <class T2, bool do_memory_op = std::numeric_limits<T2>::is_specialized>
     struct setup_t {
@@ -272,7 +537,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
         const unsigned int &rows,
         const unsigned int &columns)
         : super_t(rows, columns),
-        values(new T[rows * columns]), ref(new int(1)) {
+        values(NULL), ref(allocator_t::allocate(rows * columns, values)) {
     }
     /**
      * Constructor with initializer
@@ -286,7 +551,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
         const unsigned int &columns,
         const T *serialized)
         : super_t(rows, columns),
-        values(new T[rows * columns]), ref(new int(1)) {
+        values(NULL), ref(allocator_t::allocate(rows * columns, values)) {
       setup_t<T>::copy(*this, serialized);
     }
     /**
@@ -295,8 +560,11 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
      * @param array another one
      */
     Array2D_Dense(const self_t &array)
-        : super_t(array.m_rows, array.m_columns){
-      if(values = array.values){(*(ref = array.ref))++;}
+        : super_t(array.m_rows, array.m_columns), values(NULL), ref(NULL) {
+      if(values = array.values){allocator_t::acquire(ref = array.ref);}
+#if defined(MATRIX_COPY_ON_WRITE)
+      cow = array.cow;
+#endif
     }
     /**
      * Constructor based on another type array, which performs deep copy.
@@ -306,7 +574,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
     template <class T2>
     Array2D_Dense(const Array2D_Frozen<T2> &array)
         : super_t(array.rows(), array.columns()),
-        values(new T[array.rows() * array.columns()]), ref(new int(1)) {
+        values(NULL), ref(allocator_t::allocate(array.rows() * array.columns(), values)) {
       T *buf(values);
       for(unsigned int i(0); i < array.rows(); ++i){
         for(unsigned int j(0); j < array.columns(); ++j){
@@ -321,10 +589,7 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
      * allocated memory for elements will be deleted.
      */
     ~Array2D_Dense(){
-      if(ref && ((--(*ref)) <= 0)){
-        delete [] values;
-        delete ref;
-      }
+      if(ref){allocator_t::release(ref);}
     }
 
     /**
@@ -335,17 +600,73 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
      */
     self_t &operator=(const self_t &array){
       if(this != &array){
-        if(ref && ((--(*ref)) <= 0)){delete ref; delete [] values;}
+        if(ref){allocator_t::release(ref);}
         ref = NULL;
         if(values = array.values){
           super_t::m_rows = array.m_rows;
           super_t::m_columns = array.m_columns;
-          (*(ref = array.ref))++;
+          allocator_t::acquire(ref = array.ref);
         }
+#if defined(MATRIX_COPY_ON_WRITE)
+        cow = array.cow;
+#endif
       }
       return *this;
     }
+
+#if defined(MATRIX_COPY_ON_WRITE)
+    /**
+     * Enable copy-on-write.
+     * Afterwards, this and its shallow copies including views, which are made after the call,
+     * detach themselves by deep copy before the first write access while the storage is shared.
+     * Therefore, the elements are never modified while shared,
+     * which is required to share read-mostly matrices among threads
+     * together with MATRIX_ATOMIC_REFCOUNT.
+     * The flag is held by each holder; it must be set before the storage is shared with others.
+     *
+     * @param enable if false, copy-on-write is disabled for this holder.
+     */
+    void set_copy_on_write(const bool &enable = true){
+      cow.enabled = enable;
+    }
+
+    /**
+     * @return (bool) true when copy-on-write is enabled
+     */
+    bool is_copy_on_write() const {
+      return cow.enabled;
+    }
+
+  protected:
+    /**
+     * Replace shared storage with unshared one, which is out of line
+     * to keep element access small.
+     *
+     * @param keep_values if true, elements are copied to the replacement.
+     */
+#if defined(__GNUC__)
+    __attribute__((noinline))
+#endif
+    void detach(const bool &keep_values){
+      if(!allocator_t::shared(ref)){return;}
+      copy_on_write_t cow_orig(cow); // operator=() copies the flag of the replacement
+      *this = keep_values ? self_t(rows(), columns(), values) : self_t(rows(), columns());
+      cow = cow_orig;
+    }
+
+    /**
+     * Prepare write access.
+     *
+     * @param keep_values if true, elements are kept when the storage is replaced.
+     */
+    void prepare_write(const bool &keep_values = true){
+      if(cow.enabled && ref){detach(keep_values);}
+    }
+#else
   protected:
+    void prepare_write(const bool &keep_values = true){}
+#endif
+
     inline const T &get(
         const unsigned int &row,
         const unsigned int &column) const throws_when_debug {
@@ -372,11 +693,13 @@ class Array2D_Dense : public Array2D<T, Array2D_Dense<T> > {
     T &operator()(
         const unsigned int &row,
         const unsigned int &column) throws_when_debug {
+      prepare_write();
       return const_cast<T &>(
           const_cast<const self_t *>(this)->get(row, column));
     }
 
     void clear(){
+      prepare_write(false);
       setup_t<T>::clear(*this);
     }
 
@@ -1110,7 +1433,7 @@ struct MatrixBuilder_ViewTransformer<MatrixT<T, Array2D_ScaledUnit<T>, MatrixVie
 };
 
 template <class MatrixT>
-struct MatrixBuilder_ValueCopier {
+struct MatrixBuilder_ValueCopierBase {
   template <class T2, class Array2D_Type2, class ViewType2>
   static Matrix<T2, Array2D_Type2, ViewType2> &copy_value(
       Matrix<T2, Array2D_Type2, ViewType2> &dest, const MatrixT &src) {
@@ -1123,6 +1446,10 @@ struct MatrixBuilder_ValueCopier {
   }
 };
 
+template <class MatrixT>
+struct MatrixBuilder_ValueCopier
+    : public MatrixBuilder_ValueCopierBase<MatrixT> {};
+
 template <class MatrixT>
 struct MatrixBuilder_Dependency;
 
@@ -1191,6 +1518,9 @@ class Matrix_Frozen {
     template <class T2, class Array2D_Type2, class ViewType2>
     friend class Matrix_Frozen;
 
+    template <class MatrixT>
+    friend struct MatrixBuilder_ValueCopier;
+
     static char (&check_storage(Array2D_Frozen<T> *) )[1];
     static const int storage_t_should_be_derived_from_Array2D_Frozen
         = sizeof(check_storage(static_cast<storage_t *>(0)));
@@ -1877,6 +2207,8 @@ class Matrix_Frozen {
        * If each side include M * M, then use cache.
        * For example, (M * M) * M, and (M * M + M) * M use cache for the first parenthesis terms.
        * (M * M + M) * (M * M + M) uses cache for the first and second parenthesis terms.
+       * Nested cases, such as M * M * M * M, are cached recursively, which keeps O(n^3).
+       * Note: (M * M).inverse() does not need this, because Inverse_Matrix evaluates its operand once.
        */
       template <class MatrixT, bool cache_on = check_t<MatrixT>::has_multi_mat_by_mat>
       struct optimizer1_t {
@@ -2182,6 +2514,122 @@ class Matrix_Frozen {
       return x;
     }
 
+  protected:
+    template <class T2>
+    static T2 pivot_magnitude(const T2 &v) noexcept {return (v < T2(0)) ? -v : v;}
+    template <class T2>
+    static T2 pivot_magnitude(const Complex<T2> &v) noexcept {return v.abs2();}
+
+  public:
+    /**
+     * Resolve x of (Ax = y), where this matrix is A, without forming its inverse matrix.
+     * A working copy of A is decomposed as LU in place with partial pivoting of rows,
+     * and then forward and backward substitutions are applied to each column of y.
+     *
+     * @param y Right hand term, which can have multiple columns
+     * @param do_check Check size, the default is true.
+     * @return Left hand second term x, whose size is the same as y
+     * @throw std::logic_error When operation is undefined
+     * @throw std::invalid_argument When input is incorrect
+     * @throw std::runtime_error When A is singular
+     * @see solve_spd()
+     */
+    template <class T2, class Array2D_Type2, class ViewType2>
+    typename Matrix_Frozen<T2, Array2D_Type2, ViewType2>::builder_t::assignable_t solve(
+        const Matrix_Frozen<T2, Array2D_Type2, ViewType2> &y, const bool &do_check = true) const {
+      if(do_check){
+        if(!isSquare()){throw std::logic_error("rows() != columns()");}
+        if(y.rows() != rows()){throw std::invalid_argument("Incorrect y size");}
+      }
+      typedef typename builder_t::assignable_t lu_t;
+      typedef typename Matrix_Frozen<T2, Array2D_Type2, ViewType2>::builder_t::assignable_t x_t;
+      lu_t LU(this->operator lu_t());
+      x_t x(y.operator x_t());
+      const unsigned int n(rows()), m(y.columns());
+
+      for(unsigned int i(0); i < n; ++i){
+        unsigned int i_pivot(i);
+        for(unsigned int i2(i + 1); i2 < n; ++i2){
+          if(pivot_magnitude(LU(i2, i)) > pivot_magnitude(LU(i_pivot, i))){i_pivot = i2;}
+        }
+        if(LU(i_pivot, i) == T(0)){
+          throw std::runtime_error("LU decomposition cannot be performed");
+        }
+        if(i_pivot != i){
+          LU.swapRows(i, i_pivot);
+          x.swapRows(i, i_pivot);
+        }
+        for(unsigned int i2(i + 1); i2 < n; ++i2){ // L(i2, i) is stored in place of U(i2, i)
+          T l(LU(i2, i) /= LU(i, i));
+          for(unsigned int j(i + 1); j < n; ++j){LU(i2, j) -= l * LU(i, j);}
+          for(unsigned int j(0); j < m; ++j){x(i2, j) -= l * x(i, j);} // forward substitution
+        }
+      }
+      for(unsigned int i(n); i > 0;){ // backward substitution
+        --i;
+        for(unsigned int j(0); j < m; ++j){
+          for(unsigned int k(i + 1); k < n; ++k){x(i, j) -= LU(i, k) * x(k, j);}
+          x(i, j) /= LU(i, i);
+        }
+      }
+      return x;
+    }
+
+    /**
+     * Resolve x of (Ax = y), where this matrix is A and symmetric positive definite,
+     * such as an innovation covariance matrix, without forming its inverse matrix.
+     * A working copy of A is decomposed in place with square root free Cholesky (LDL^T)
+     * decomposition, whose cost is about half of solve().
+     * Only the lower triangle of A is referred, therefore A having asymmetry
+     * due to rounding errors is acceptable.
+     *
+     * @param y Right hand term, which can have multiple columns
+     * @param do_check Check size, the default is true.
+     * @return Left hand second term x, whose size is the same as y
+     * @throw std::logic_error When operation is undefined
+     * @throw std::invalid_argument When input is incorrect
+     * @throw std::runtime_error When A is not positive definite
+     * @see solve()
+     */
+    template <class T2, class Array2D_Type2, class ViewType2>
+    typename Matrix_Frozen<T2, Array2D_Type2, ViewType2>::builder_t::assignable_t solve_spd(
+        const Matrix_Frozen<T2, Array2D_Type2, ViewType2> &y, const bool &do_check = true) const {
+      if(do_check){
+        if(!isSquare()){throw std::logic_error("rows() != columns()");}
+        if(y.rows() != rows()){throw std::invalid_argument("Incorrect y size");}
+      }
+      typedef typename builder_t::assignable_t ld_t;
+      typedef typename Matrix_Frozen<T2, Array2D_Type2, ViewType2>::builder_t::assignable_t x_t;
+      ld_t LD(this->operator ld_t()); // (i, i): D, (i, j) for i > j: L
+      x_t x(y.operator x_t());
+      const unsigned int n(rows()), m(y.columns());
+
+      // LD(i, k) for i > k keeps L(i, k) * D(k, k) until the i-th row is processed.
+      for(unsigned int j(0); j < n; ++j){
+        for(unsigned int k(0); k < j; ++k){
+          T ld(LD(j, k));
+          LD(j, j) -= ld * (LD(j, k) /= LD(k, k));
+        }
+        if(!(LD(j, j) > T(0))){
+          throw std::runtime_error("Cholesky decomposition cannot be performed");
+        }
+        for(unsigned int i(j + 1); i < n; ++i){
+          for(unsigned int k(0); k < j; ++k){LD(i, j) -= LD(i, k) * LD(j, k);}
+        }
+      }
+      for(unsigned int j(0); j < m; ++j){
+        for(unsigned int i(0); i < n; ++i){ // L z = y
+          for(unsigned int k(0); k < i; ++k){x(i, j) -= LD(i, k) * x(k, j);}
+        }
+        for(unsigned int i(0); i < n; ++i){x(i, j) /= LD(i, i);} // D w = z
+        for(unsigned int i(n); i > 0;){ // L^T x = w
+          --i;
+          for(unsigned int k(i + 1); k < n; ++k){x(i, j) -= LD(k, i) * x(k, j);}
+        }
+      }
+      return x;
+    }
+
     /**
      * Calculate determinant by using LU decomposition
      *
@@ -2288,10 +2736,6 @@ class Matrix_Frozen {
         //std::cout << "R:" << right << std::endl;
 
         return right;
-
-        // TODO: method to use LU decomposition
-        /*
-        */
       }
     };
     template <class U>
@@ -2304,6 +2748,7 @@ class Matrix_Frozen {
 
     /**
      * Calculate inverse matrix
+     * To obtain A^{-1} y, use solve() or solve_spd() instead, which does not form the inverse.
      *
      * @return Inverse matrix
      * @throw std::logic_error When operation is undefined
@@ -3007,6 +3452,185 @@ struct Array2D_Operator_Multiply_by_Matrix<
   }
 };
 
+/**
+ * @brief Multiplication kernel working on raw buffers of Array2D_Dense
+ *
+ * The product is calculated with cache blocking over columns and inner products,
+ * and the innermost loop c[j] += a * b[j] walks continuous memory and is vectorized if possible.
+ * Each element is accumulated from zero in ascending order of k,
+ * which is the same as Array2D_Operator_Multiply_by_Matrix::operator(),
+ * therefore the result is identical to the expression template version.
+ *
+ * @param T precision
+ */
+template <class T>
+struct Array2D_Dense_Multiplier {
+  static const unsigned int block_k = 64;
+  static const unsigned int block_j = 256;
+
+  static void axpy(T *c, const T &a, const T *b, const unsigned int &n){
+    for(unsigned int j(0); j < n; ++j){
+      c[j] += a * b[j];
+    }
+  }
+
+  /**
+   * Calculate c = a * b
+   *
+   * @param c result of (m, n) size, row-major
+   * @param a left hand side of (m, l) size, whose (i, k) element is a[i * a_row + k * a_column]
+   * @param b right hand side of (l, n) size, row-major
+   */
+  static void run(
+      T *c, const unsigned int &m, const unsigned int &n, const unsigned int &l,
+      const T *a, const unsigned int &a_row, const unsigned int &a_column,
+      const T *b){
+    for(unsigned int i(0), i_end(m * n); i < i_end; ++i){c[i] = T(0);}
+    for(unsigned int j0(0); j0 < n; j0 += block_j){
+      unsigned int nj((n - j0) < block_j ? (n - j0) : block_j);
+      for(unsigned int k0(0); k0 < l; k0 += block_k){
+        unsigned int k_end((l - k0) < block_k ? l : (k0 + block_k));
+        for(unsigned int i(0); i < m; ++i){
+          T *c_i(&c[i * n + j0]);
+          const T *a_i(&a[i * a_row]);
+          for(unsigned int k(k0); k < k_end; ++k){
+            axpy(c_i, a_i[k * a_column], &b[k * n + j0], nj);
+          }
+        }
+      }
+    }
+  }
+};
+
+#if defined(MATRIX_USE_AVX)
+template <>
+inline void Array2D_Dense_Multiplier<double>::axpy(
+    double *c, const double &a, const double *b, const unsigned int &n){
+  unsigned int j(0);
+  __m256d a_4(_mm256_set1_pd(a));
+  for(; j + 4 <= n; j += 4){
+    _mm256_storeu_pd(&c[j],
+        _mm256_add_pd(_mm256_loadu_pd(&c[j]), _mm256_mul_pd(a_4, _mm256_loadu_pd(&b[j]))));
+  }
+  for(; j < n; ++j){c[j] += a * b[j];}
+}
+template <>
+inline void Array2D_Dense_Multiplier<float>::axpy(
+    float *c, const float &a, const float *b, const unsigned int &n){
+  unsigned int j(0);
+  __m256 a_8(_mm256_set1_ps(a));
+  for(; j + 8 <= n; j += 8){
+    _mm256_storeu_ps(&c[j],
+        _mm256_add_ps(_mm256_loadu_ps(&c[j]), _mm256_mul_ps(a_8, _mm256_loadu_ps(&b[j]))));
+  }
+  for(; j < n; ++j){c[j] += a * b[j];}
+}
+#elif defined(MATRIX_USE_SSE2)
+template <>
+inline void Array2D_Dense_Multiplier<double>::axpy(
+    double *c, const double &a, const double *b, const unsigned int &n){
+  unsigned int j(0);
+  __m128d a_2(_mm_set1_pd(a));
+  for(; j + 2 <= n; j += 2){
+    _mm_storeu_pd(&c[j],
+        _mm_add_pd(_mm_loadu_pd(&c[j]), _mm_mul_pd(a_2, _mm_loadu_pd(&b[j]))));
+  }
+  for(; j < n; ++j){c[j] += a * b[j];}
+}
+template <>
+inline void Array2D_Dense_Multiplier<float>::axpy(
+    float *c, const float &a, const float *b, const unsigned int &n){
+  unsigned int j(0);
+  __m128 a_4(_mm_set1_ps(a));
+  for(; j + 4 <= n; j += 4){
+    _mm_storeu_ps(&c[j],
+        _mm_add_ps(_mm_loadu_ps(&c[j]), _mm_mul_ps(a_4, _mm_loadu_ps(&b[j]))));
+  }
+  for(; j < n; ++j){c[j] += a * b[j];}
+}
+#endif
+
+/**
+ * Views of Array2D_Dense which can be handled by Array2D_Dense_Multiplier,
+ * i.e., no view or transpose only.
+ */
+template <class ViewType>
+struct Array2D_Dense_MultiplierView {
+  static const bool supported = false;
+  static const bool transposed = false;
+};
+template <>
+struct Array2D_Dense_MultiplierView<MatrixViewBase<> > {
+  static const bool supported = true;
+  static const bool transposed = false;
+};
+template <>
+struct Array2D_Dense_MultiplierView<MatrixViewTranspose<MatrixViewBase<> > > {
+  static const bool supported = true;
+  static const bool transposed = true;
+};
+
+/**
+ * Assignment of (dense matrix) * (dense matrix) into a dense matrix
+ * utilizes Array2D_Dense_Multiplier instead of element-wise evaluation
+ * with Array2D_Operator_Multiply_by_Matrix::operator().
+ */
+template <class T, class ViewType_L, class ViewType_R>
+struct MatrixBuilder_ValueCopier<
+    Matrix_Frozen<T, Array2D_Operator<T, Array2D_Operator_Multiply_by_Matrix<
+      Matrix_Frozen<T, Array2D_Dense<T>, ViewType_L>,
+      Matrix_Frozen<T, Array2D_Dense<T>, ViewType_R> > >, MatrixViewBase<> > >
+    : public MatrixBuilder_ValueCopierBase<
+      Matrix_Frozen<T, Array2D_Operator<T, Array2D_Operator_Multiply_by_Matrix<
+        Matrix_Frozen<T, Array2D_Dense<T>, ViewType_L>,
+        Matrix_Frozen<T, Array2D_Dense<T>, ViewType_R> > >, MatrixViewBase<> > > {
+  typedef Matrix_Frozen<T, Array2D_Dense<T>, ViewType_L> lhs_t;
+  typedef Matrix_Frozen<T, Array2D_Dense<T>, ViewType_R> rhs_t;
+  typedef Matrix_Frozen<T, Array2D_Operator<T, Array2D_Operator_Multiply_by_Matrix<
+      lhs_t, rhs_t> >, MatrixViewBase<> > src_t;
+  typedef MatrixBuilder_ValueCopierBase<src_t> super_t;
+  typedef Matrix_Frozen<T, Array2D_Dense<T>, MatrixViewBase<> > dest_t;
+
+  using super_t::copy_value;
+
+  static Matrix<T, Array2D_Dense<T>, MatrixViewBase<> > &copy_value(
+      Matrix<T, Array2D_Dense<T>, MatrixViewBase<> > &dest, const src_t &src){
+    typedef Array2D_Dense_MultiplierView<ViewType_L> view_L;
+    typedef Array2D_Dense_MultiplierView<ViewType_R> view_R;
+    const lhs_t &lhs(src.storage.op.lhs);
+    const rhs_t &rhs(src.storage.op.rhs);
+    static_cast<dest_t &>(dest).storage.prepare_write(false);
+    T *c(static_cast<dest_t &>(dest).storage.values);
+    const T *a(lhs.storage.values), *b(rhs.storage.values);
+    if((!view_L::supported) || (!view_R::supported)
+        || (c == a) || (c == b)){ // aliasing results in wrong answer
+      return super_t::copy_value(dest, src);
+    }
+    const unsigned int m(lhs.rows()), n(rhs.columns()), l(lhs.columns());
+    if(!view_R::transposed){
+      Array2D_Dense_Multiplier<T>::run(
+          c, m, n, l,
+          a, (view_L::transposed ? 1 : l), (view_L::transposed ? m : 1),
+          b);
+    }else{
+      // Transposed right hand side is rearranged into row-major order at first,
+      // whose buffer is obtained from the pool as well as the other storages.
+      Array2D_Dense<T> packed(l, n);
+      T *b_packed(packed.values);
+      for(unsigned int k(0); k < l; ++k){
+        for(unsigned int j(0); j < n; ++j){
+          b_packed[k * n + j] = b[j * l + k];
+        }
+      }
+      Array2D_Dense_Multiplier<T>::run(
+          c, m, n, l,
+          a, (view_L::transposed ? 1 : l), (view_L::transposed ? m : 1),
+          b_packed);
+    }
+    return dest;
+  }
+};
+
 /*
  * Downcast rules including operation
  * When multiplication of multiple matrices, the most left and right hand terms are extracted intermediately.
@@ -3303,6 +3927,24 @@ class Matrix : public Matrix_Frozen<T, Array2D_Type, ViewType> {
       return copy_t<view_property_t::viewless>::run(*this);
     }
 
+#if defined(MATRIX_COPY_ON_WRITE)
+    /**
+     * Enable copy-on-write, then the shared elements are not modified
+     * through this matrix and its shallow copies made afterwards,
+     * because a writer obtains its own storage by deep copy at first.
+     * Be careful, a view such as partial() of this matrix is also detached when it is written,
+     * then, the modification is not reflected to the original one.
+     *
+     * @param enable if false, copy-on-write is disabled.
+     * @return myself
+     * @see Array2D_Dense::set_copy_on_write()
+     */
+    self_t &copy_on_write(const bool &enable = true){
+      storage.storage_t::set_copy_on_write(enable);
+      return *this;
+    }
+#endif
+
   protected:
     /**
      * Cast to another Matrix defined in Matrix_Frozen is intentionally protected.
@@ -383,6 +383,204 @@ struct MatrixBuilder_ValueCopier<
     return dest;
   }
 };
+
+/**
+ * @brief Array2D for symmetric matrix, which stores only upper triangle elements.
+ *
+ * The (i, j) element where i <= j is mapped to [i * (2n - i + 1) / 2 + (j - i)],
+ * and the (j, i) element shares the same memory.
+ * Therefore, n * (n + 1) / 2 elements are stored, and symmetry is always guaranteed.
+ * Memory management including reference counter is the same as Array2D_Dense.
+ *
+ * @param T precision, for example, double
+ */
+template <class T>
+class Array2D_SymmetricPacked : public Array2D<T, Array2D_SymmetricPacked<T> > {
+  public:
+    typedef Array2D_SymmetricPacked<T> self_t;
+    typedef Array2D<T, self_t> super_t;
+
+    template <class T2>
+    struct family_t {
+      typedef Array2D_SymmetricPacked<T2> res_t;
+    };
+
+    using super_t::rows;
+    using super_t::columns;
+
+  protected:
+    typedef Array2D_Dense_Allocator<T> allocator_t;
+    typedef typename allocator_t::counter_t counter_t;
+    T *values; ///< array for upper triangle values
+    counter_t *ref;  ///< reference counter
+
+    static unsigned int packed_size(const unsigned int &size){
+      return size * (size + 1) / 2;
+    }
+    static unsigned int check_size(const unsigned int &rows, const unsigned int &columns){
+      if(rows != columns){
+        throw std::invalid_argument("Not square");
+      }
+      return packed_size(rows);
+    }
+
+  public:
+    Array2D_SymmetricPacked() : super_t(0, 0), values(NULL), ref(NULL) {}
+
+    /**
+     * Constructor
+     *
+     * @param rows Rows
+     * @param columns Columns, which must be the same as rows
+     */
+    Array2D_SymmetricPacked(
+        const unsigned int &rows,
+        const unsigned int &columns)
+        : super_t(rows, columns),
+        values(NULL), ref(allocator_t::allocate(check_size(rows, columns), values)) {
+    }
+    /**
+     * Constructor with initializer, whose lower triangle is ignored.
+     *
+     * @param rows Rows
+     * @param columns Columns, which must be the same as rows
+     * @param serialized Initializer of (rows * columns) size
+     */
+    Array2D_SymmetricPacked(
+        const unsigned int &rows,
+        const unsigned int &columns,
+        const T *serialized)
+        : super_t(rows, columns),
+        values(NULL), ref(allocator_t::allocate(check_size(rows, columns), values)) {
+      T *buf(values);
+      for(unsigned int i(0); i < rows; ++i){
+        for(unsigned int j(i); j < columns; ++j){
+          *(buf++) = serialized[i * columns + j];
+        }
+      }
+    }
+    /**
+     * Copy constructor, which performs shallow copy.
+     *
+     * @param array another one
+     */
+    Array2D_SymmetricPacked(const self_t &array)
+        : super_t(array.m_rows, array.m_columns), values(array.values), ref(array.ref) {
+      if(ref){allocator_t::acquire(ref);}
+    }
+    /**
+     * Constructor based on another type array, which performs deep copy.
+     * Only upper triangle of the array is used.
+     *
+     * @param array another one
+     */
+    template <class T2>
+    Array2D_SymmetricPacked(const Array2D_Frozen<T2> &array)
+        : super_t(array.rows(), array.columns()),
+        values(NULL), ref(allocator_t::allocate(check_size(array.rows(), array.columns()), values)) {
+      T *buf(values);
+      for(unsigned int i(0); i < array.rows(); ++i){
+        for(unsigned int j(i); j < array.columns(); ++j){
+          *(buf++) = array(i, j);
+        }
+      }
+    }
+    ~Array2D_SymmetricPacked(){
+      if(ref){allocator_t::release(ref);}
+    }
+
+    /**
+     * Assigner, which performs shallow copy.
+     *
+     * @param array another one
+     * @return self_t
+     */
+    self_t &operator=(const self_t &array){
+      if(this != &array){
+        if(ref){allocator_t::release(ref);}
+        ref = NULL;
+        if(values = array.values){
+          super_t::m_rows = array.m_rows;
+          super_t::m_columns = array.m_columns;
+          allocator_t::acquire(ref = array.ref);
+        }
+      }
+      return *this;
+    }
+  protected:
+    inline const T &get(
+        const unsigned int &row,
+        const unsigned int &column) const throws_when_debug {
+#if defined(DEBUG)
+      super_t::check_index(row, column);
+#endif
+      return (row <= column)
+          ? values[row * (rows() * 2 - row + 1) / 2 + (column - row)]
+          : values[column * (rows() * 2 - column + 1) / 2 + (row - column)];
+    }
+
+  public:
+    /**
+     * Accessor for element
+     *
+     * @param row Row index
+     * @param column Column Index
+     * @return (T) Element
+     * @throw std::out_of_range When the indices are out of range
+     */
+    T operator()(
+        const unsigned int &row,
+        const unsigned int &column) const throws_when_debug {
+      return get(row, column);
+    }
+    /**
+     * Accessor for element, where writing to (i, j) element also changes (j, i) element.
+     */
+    T &operator()(
+        const unsigned int &row,
+        const unsigned int &column) throws_when_debug {
+      return const_cast<T &>(
+          const_cast<const self_t *>(this)->get(row, column));
+    }
+
+    void clear(){
+      for(int i(packed_size(rows()) - 1); i >= 0; --i){
+        values[i] = T(0);
+      }
+    }
+
+    /**
+     * Perform copy
+     *
+     * @param is_deep If true, return deep copy, otherwise return shallow copy (just link).
+     * @return (self_t) copy
+     */
+    self_t copy(const bool &is_deep = false) const {
+      if(!is_deep){return self_t(*this);}
+      self_t res(rows(), columns());
+      for(int i(packed_size(rows()) - 1); i >= 0; --i){
+        res.values[i] = values[i];
+      }
+      return res;
+    }
+};
+
+/*
+ * Results of operations including a packed symmetric matrix are not always symmetric,
+ * therefore they are assigned to (dense) Matrix.
+ * Use Matrix<T, Array2D_SymmetricPacked<T> >(src) explicitly for packed copy.
+ */
+template <
+    template <class, class, class> class MatrixT,
+    class T, class ViewType>
+struct MatrixBuilder_Dependency<MatrixT<T, Array2D_SymmetricPacked<T>, ViewType> > {
+  typedef Matrix<T> assignable_t;
+
+  template <class T2>
+  struct family_t {
+    typedef typename MatrixBuilder<Matrix<T2> >::assignable_t assignable_t;
+  };
+};
 // }
 
 // Diagonal {
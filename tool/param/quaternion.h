@@ -206,9 +206,87 @@ class QuaternionData : public QuaternionDataProperty<FloatT> {
     }
 };
 
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1900))
+#define QUATERNION_ALIGNAS(x) alignas(x)
+#else
+#define QUATERNION_ALIGNAS(x)
+#endif
+
+/**
+ * Quaternion data type without fly weight design pattern, which holds values by itself.
+ * Copy is always deep, and no heap allocation is performed.
+ * The elements are aligned to 16 bytes for SIMD instructions if possible.
+ * This is the default; @see QuaternionData_TypeMapper
+ */
+template <class FloatT>
+class QUATERNION_ALIGNAS(16) QuaternionData_NoFlyWeight : public QuaternionDataProperty<FloatT> {
+  protected:
+    typedef QuaternionDataProperty<FloatT> property_t;
+    typedef QuaternionData_NoFlyWeight<FloatT> self_t;
+  private:
+    FloatT _scalar;
+    Vector3<FloatT> _vector;
+  protected:
+    QuaternionData_NoFlyWeight(){}
+    QuaternionData_NoFlyWeight(const FloatT &q0, const Vector3<FloatT> &v)
+        : _scalar(q0), _vector(v){}
+    QuaternionData_NoFlyWeight(
+        const FloatT &q0, const FloatT &q1,
+        const FloatT &q2, const FloatT &q3) noexcept
+        : _scalar(q0), _vector(q1, q2, q3) {}
+    QuaternionData_NoFlyWeight(const FloatT (&v)[property_t::OUT_OF_INDEX]) noexcept
+        : _scalar(v[0]), _vector((const FloatT (&)[property_t::OUT_OF_INDEX - 1])*(&v[1])) {}
+    QuaternionData_NoFlyWeight(const self_t &q) noexcept
+        : _scalar(q._scalar), _vector(q._vector){
+    }
+    self_t &operator=(const self_t &q) noexcept {
+      _scalar = q._scalar;
+      _vector = q._vector;
+      return *this;
+    }
+    self_t deep_copy() const{
+      return self_t(_scalar, _vector.copy());
+    }
+  public:
+    ~QuaternionData_NoFlyWeight() noexcept {}
+    const FloatT &scalar() const noexcept {return _scalar;}
+    FloatT &scalar() noexcept {
+      return const_cast<FloatT &>(static_cast<const self_t &>(*this).scalar());
+    }
+    const Vector3<FloatT> &vector() const noexcept {return _vector;}
+    Vector3<FloatT> &vector() noexcept {
+      return const_cast<Vector3<FloatT> &>(static_cast<const self_t &>(*this).vector());
+    }
+    const FloatT &operator[](const unsigned &index) const {
+      if(index == 0){return _scalar;}
+      else{return _vector[index - 1];}
+    }
+    FloatT &operator[](const unsigned &index){
+      return const_cast<FloatT &>(static_cast<const self_t &>(*this)[index]);
+    }
+};
+
+#undef QUATERNION_ALIGNAS
+
+/**
+ * Storage type of Quaternion for each precision
+ *
+ * Value storage (QuaternionData_NoFlyWeight) is used by default.
+ * For code relying on the shallow copy semantics of the former default,
+ * the fly weight storage (QuaternionData) can be restored by defining QUATERNION_FLYWEIGHT
+ * before inclusion of this file, or only for a specific precision by
+ * template <>
+ * struct QuaternionData_TypeMapper<double> {
+ *   typedef QuaternionData<double> res_t;
+ * };
+ */
 template <class FloatT>
 struct QuaternionData_TypeMapper {
+#if defined(QUATERNION_FLYWEIGHT)
   typedef QuaternionData<FloatT> res_t;
+#else
+  typedef QuaternionData_NoFlyWeight<FloatT> res_t;
+#endif
 };
 
 /**
@@ -226,10 +304,10 @@ struct QuaternionData_TypeMapper {
  * @f$ \tan{\frac{\pi}{2}} @f$Ƃٓ_邱ƂłA
  * 炩ȉZsƂ\łB
  * 
- * ȂAIɎQƃJE^𗘗pCgEGCgȎɂȂĂ邽߁A
- * ≉Z񐔂ߖ񂳂邱Ƃ@̂܂B
- * ̂߂ɖIcopy()\bhgpȂƃfB[vRs[Ȃ̂ŁA
- * ėpsۂ͒ӂĂB
+ * ȂAł͗vfɕێ邽߁ARs[͏ɃfB[vRs[ƂȂA
+ * ꎞIuWFNg̐ɂq[vmۂs܂B
+ * QƃJE^𗘗pCgEGCgȎ(V[Rs[)Kvȏꍇ́A
+ * QuaternionData_TypeMapperQƂĂB
  * 
  * @param FloatT ZxAdoubleȂ
  * @see Vector3<FloatT>
@@ -365,6 +443,29 @@ class Quaternion : public QuaternionData_TypeMapper<FloatT>::res_t {
       return self_t(scalar(), -vector());
     }
 
+    /**
+     * Rotate a vector, i.e., calculate the vector part of
+     * @f$ \Tilde{q} \vec{v} \Tilde{q}^{*} @f$ without quaternion products by
+     * @f[
+     *    (q_{0}^{2} - \vec{q} \cdot \vec{q}) \vec{v}
+     *      + 2 (\vec{q} \cdot \vec{v}) \vec{q} + 2 q_{0} \vec{q} \times \vec{v}.
+     * @f]
+     * Like the product form, the result is scaled by @f$ \left| \Tilde{q} \right|^{2} @f$.
+     * For the inverse rotation, use conj().rotate(v).
+     *
+     * @param v vector to be rotated
+     * @return (Vector3<FloatT>) rotated vector
+     */
+    Vector3<FloatT> rotate(const Vector3<FloatT> &v) const {
+      const FloatT &q0(scalar());
+      const Vector3<FloatT> &u(vector());
+      FloatT s(q0 * q0 - u.abs2()), uv2(u.innerp(v) * 2), q0_2(q0 * 2);
+      return Vector3<FloatT>(
+          s * v[0] + uv2 * u[0] + q0_2 * (u[1] * v[2] - u[2] * v[1]),
+          s * v[1] + uv2 * u[1] + q0_2 * (u[2] * v[0] - u[0] * v[2]),
+          s * v[2] + uv2 * u[2] + q0_2 * (u[0] * v[1] - u[1] * v[0]));
+    }
+
 #ifndef pow2
 #define pow2(x) ((x) * (x))
 #else
@@ -435,6 +536,49 @@ class Quaternion : public QuaternionData_TypeMapper<FloatT>::res_t {
      */
     self_t regularize() const{return (*this) / abs();}
     
+  protected:
+    /**
+     * Kernel of quaternion product, whose specialization may utilize SIMD instructions.
+     * The result must not be identical to the operands.
+     */
+    template <class DataT = super_t, class U = void>
+    struct multiplier_t {
+      static void run(const self_t &a, const self_t &b, self_t &r) noexcept {
+        r[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+        r[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+        r[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+        r[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+      }
+    };
+#if defined(MATRIX_USE_SSE2)
+    template <class U>
+    struct multiplier_t<QuaternionData_NoFlyWeight<double>, U> {
+      static void run(const self_t &a, const self_t &b, self_t &r) noexcept {
+        // r = a0 * (b0, b1, b2, b3) + a1 * (-b1, b0, -b3, b2)
+        //     + a2 * (-b2, b3, b0, -b1) + a3 * (-b3, -b2, b1, b0)
+        const __m128d sign_lo(_mm_set_pd(0.0, -0.0)), sign_hi(_mm_set_pd(-0.0, 0.0));
+        __m128d b_lo(_mm_set_pd(b[1], b[0])), b_hi(_mm_set_pd(b[3], b[2]));
+        __m128d b_lo_swap(_mm_shuffle_pd(b_lo, b_lo, 1)), b_hi_swap(_mm_shuffle_pd(b_hi, b_hi, 1));
+        __m128d a_i(_mm_set1_pd(a[0]));
+        __m128d r_lo(_mm_mul_pd(a_i, b_lo)), r_hi(_mm_mul_pd(a_i, b_hi));
+        a_i = _mm_set1_pd(a[1]);
+        r_lo = _mm_add_pd(r_lo, _mm_mul_pd(a_i, _mm_xor_pd(b_lo_swap, sign_lo)));
+        r_hi = _mm_add_pd(r_hi, _mm_mul_pd(a_i, _mm_xor_pd(b_hi_swap, sign_lo)));
+        a_i = _mm_set1_pd(a[2]);
+        r_lo = _mm_add_pd(r_lo, _mm_mul_pd(a_i, _mm_xor_pd(b_hi, sign_lo)));
+        r_hi = _mm_add_pd(r_hi, _mm_mul_pd(a_i, _mm_xor_pd(b_lo, sign_hi)));
+        a_i = _mm_set1_pd(a[3]);
+        r_lo = _mm_sub_pd(r_lo, _mm_mul_pd(a_i, b_hi_swap));
+        r_hi = _mm_add_pd(r_hi, _mm_mul_pd(a_i, b_lo_swap));
+        _mm_storel_pd(&r[0], r_lo);
+        _mm_storeh_pd(&r[1], r_lo);
+        _mm_storel_pd(&r[2], r_hi);
+        _mm_storeh_pd(&r[3], r_hi);
+      }
+    };
+#endif
+
+  public:
     /**
      * NH[^jIƂ̐ώZs܂B
      * ώZ @f$ \Tilde{q}_{a} \Tilde{q}_{b} @f$
@@ -452,12 +596,8 @@ class Quaternion : public QuaternionData_TypeMapper<FloatT>::res_t {
      * @return (Quaternion<FloatT>) 
      */
     self_t operator*(const self_t &q) const{
-      self_t result((
-          scalar() * q.scalar())
-            - (vector().innerp(q.vector())),
-          (q.vector() * scalar())
-            += (vector() * q.scalar())
-            += (vector() * q.vector()));
+      self_t result;
+      multiplier_t<>::run(*this, q, result);
       return result;
     }
     
@@ -700,63 +840,6 @@ class Quaternion : public QuaternionData_TypeMapper<FloatT>::res_t {
     }
 };
 
-/**
- * Quaternion data type without fly weight design pattern for performance tuning
- *
- * To use this, the following example may be helpful:
- * template <>
- * struct QuaternionData_TypeMapper<double> {
- *   typedef QuaternionData_NoFlyWeight<double> res_t;
- * };
- */
-template <class FloatT>
-class QuaternionData_NoFlyWeight : public QuaternionDataProperty<FloatT> {
-  protected:
-    typedef QuaternionDataProperty<FloatT> property_t;
-    typedef QuaternionData_NoFlyWeight<FloatT> self_t;
-  private:
-    FloatT _scalar;
-    Vector3<FloatT> _vector;
-  protected:
-    QuaternionData_NoFlyWeight(){}
-    QuaternionData_NoFlyWeight(const FloatT &q0, const Vector3<FloatT> &v)
-        : _scalar(q0), _vector(v){}
-    QuaternionData_NoFlyWeight(
-        const FloatT &q0, const FloatT &q1,
-        const FloatT &q2, const FloatT &q3) noexcept
-        : _scalar(q0), _vector(q1, q2, q3) {}
-    QuaternionData_NoFlyWeight(const FloatT (&v)[property_t::OUT_OF_INDEX]) noexcept
-        : _scalar(v[0]), _vector((const FloatT (&)[property_t::OUT_OF_INDEX - 1])*(&v[1])) {}
-    QuaternionData_NoFlyWeight(const self_t &q) noexcept
-        : _scalar(q._scalar), _vector(q._vector){
-    }
-    self_t &operator=(const self_t &q) noexcept {
-      _scalar = q._scalar;
-      _vector = q._vector;
-      return *this;
-    }
-    self_t deep_copy() const{
-      return self_t(_scalar, _vector.copy());
-    }
-  public:
-    ~QuaternionData_NoFlyWeight() noexcept {}
-    const FloatT &scalar() const noexcept {return _scalar;}
-    FloatT &scalar() noexcept {
-      return const_cast<FloatT &>(static_cast<const self_t &>(*this).scalar());
-    }
-    const Vector3<FloatT> &vector() const noexcept {return _vector;}
-    Vector3<FloatT> &vector() noexcept {
-      return const_cast<Vector3<FloatT> &>(static_cast<const self_t &>(*this).vector());
-    }
-    const FloatT &operator[](const unsigned &index) const {
-      if(index == 0){return _scalar;}
-      else{return _vector[index - 1];}
-    }
-    FloatT &operator[](const unsigned &index){
-      return const_cast<FloatT &>(static_cast<const self_t &>(*this)[index]);
-    }
-};
-
 #if (__cplusplus < 201103L) && defined(noexcept)
 #undef noexcept
 #endif
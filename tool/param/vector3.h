@@ -187,9 +187,73 @@ class Vector3Data : public Vector3DataProperty<FloatT> {
     }
 };
 
+/**
+ * Vector3 data type without fly weight design pattern for performance tuning
+ *
+ * To use this, the following example may be helpful:
+ * template <>
+ * struct Vector3Data_TypeMapper<double> {
+ *   typedef Vector3Data_NoFlyWeight<double> res_t;
+ * };
+ */
+template <class FloatT>
+class Vector3Data_NoFlyWeight : public Vector3DataProperty<FloatT> {
+  protected:
+    typedef Vector3DataProperty<FloatT> property_t;
+    typedef Vector3Data_NoFlyWeight<FloatT> self_t;
+  private:
+    FloatT values[property_t::OUT_OF_INDEX];
+  protected:
+    Vector3Data_NoFlyWeight() noexcept {}
+    Vector3Data_NoFlyWeight(const FloatT &x, const FloatT &y, const FloatT &z) noexcept {
+      values[property_t::X_INDEX] = x;
+      values[property_t::Y_INDEX] = y;
+      values[property_t::Z_INDEX] = z;
+    }
+    Vector3Data_NoFlyWeight(const FloatT (&v)[property_t::OUT_OF_INDEX]) noexcept {
+      std::memcpy(values, &v, sizeof(values));
+    }
+    Vector3Data_NoFlyWeight(const self_t &v) noexcept {
+      std::memcpy(values, v.values, sizeof(values));
+    }
+    self_t &operator=(const self_t &v) noexcept {
+      std::memcpy(values, v.values, sizeof(values));
+      return *this;
+    }
+    self_t deep_copy() const {
+      self_t copied;
+      std::memcpy(copied.values, values, sizeof(values));
+      return copied;
+    }
+  public:
+    ~Vector3Data_NoFlyWeight() noexcept {}
+    const FloatT &operator[](const unsigned int &index) const {
+      return values[index];
+    }
+    FloatT &operator[](const unsigned int &index){
+      return const_cast<FloatT &>(static_cast<const self_t &>(*this)[index]);
+    }
+};
+
+/**
+ * Storage type of Vector3 for each precision
+ *
+ * Value storage (Vector3Data_NoFlyWeight) is used by default.
+ * For code relying on the shallow copy semantics of the former default,
+ * the fly weight storage (Vector3Data) can be restored by defining VECTOR3_FLYWEIGHT
+ * before inclusion of this file, or only for a specific precision by
+ * template <>
+ * struct Vector3Data_TypeMapper<double> {
+ *   typedef Vector3Data<double> res_t;
+ * };
+ */
 template <class FloatT>
 struct Vector3Data_TypeMapper {
+#if defined(VECTOR3_FLYWEIGHT)
   typedef Vector3Data<FloatT> res_t;
+#else
+  typedef Vector3Data_NoFlyWeight<FloatT> res_t;
+#endif
 };
 
 /**
@@ -198,10 +262,10 @@ struct Vector3Data_TypeMapper {
  * 3xNgNXB
  * xNgg̒`ςOςȂǂ܂߂lXȉZ̒`sĂ܂B
  * 
- * ȂAIɎQƃJE^𗘗pCgEGCgȎɂȂĂ邽߁A
- * ≉Z񐔂ߖ񂳂邱Ƃ@̂܂B
- * ̂߂ɖIcopy()\bhgpȂƃfB[vRs[Ȃ̂ŁA
- * ėpsۂ͒ӂĂB
+ * ȂAł͗vfɕێ邽߁ARs[͏ɃfB[vRs[ƂȂA
+ * ꎞIuWFNg̐ɂq[vmۂs܂B
+ * QƃJE^𗘗pCgEGCgȎ(V[Rs[)Kvȏꍇ́A
+ * Vector3Data_TypeMapperQƂĂB
  * 
  * @param FloatT ZxAdoubleȂ
  */
@@ -596,54 +660,6 @@ class Vector3 : public Vector3Data_TypeMapper<FloatT>::res_t {
     }
 };
 
-/**
- * Vector3 data type without fly weight design pattern for performance tuning
- *
- * To use this, the following example may be helpful:
- * template <>
- * struct Vector3Data_TypeMapper<double> {
- *   typedef Vector3Data_NoFlyWeight<double> res_t;
- * };
- */
-template <class FloatT>
-class Vector3Data_NoFlyWeight : public Vector3DataProperty<FloatT> {
-  protected:
-    typedef Vector3DataProperty<FloatT> property_t;
-    typedef Vector3Data_NoFlyWeight<FloatT> self_t;
-  private:
-    FloatT values[property_t::OUT_OF_INDEX];
-  protected:
-    Vector3Data_NoFlyWeight() noexcept {}
-    Vector3Data_NoFlyWeight(const FloatT &x, const FloatT &y, const FloatT &z) noexcept {
-      values[property_t::X_INDEX] = x;
-      values[property_t::Y_INDEX] = y;
-      values[property_t::Z_INDEX] = z;
-    }
-    Vector3Data_NoFlyWeight(const FloatT (&v)[property_t::OUT_OF_INDEX]) noexcept {
-      std::memcpy(values, &v, sizeof(values));
-    }
-    Vector3Data_NoFlyWeight(const self_t &v) noexcept {
-      std::memcpy(values, v.values, sizeof(values));
-    }
-    self_t &operator=(const self_t &v) noexcept {
-      std::memcpy(values, v.values, sizeof(values));
-      return *this;
-    }
-    self_t deep_copy() const {
-      self_t copied;
-      std::memcpy(copied.values, values, sizeof(values));
-      return copied;
-    }
-  public:
-    ~Vector3Data_NoFlyWeight() noexcept {}
-    const FloatT &operator[](const unsigned int &index) const {
-      return values[index];
-    }
-    FloatT &operator[](const unsigned int &index){
-      return const_cast<FloatT &>(static_cast<const self_t &>(*this)[index]);
-    }
-};
-
 #if (__cplusplus < 201103L) && defined(noexcept)
 #undef noexcept
 #endif
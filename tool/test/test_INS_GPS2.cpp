@@ -0,0 +1,737 @@
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+
+#include "navigation/INS_GPS_Factory.h"
+#include "navigation/INS_GPS_Synchronization.h"
+#include "algorithm/kalman_fixed.h"
+#include "algorithm/kalman_symmetric.h"
+#include "navigation/EGM_Grid.h"
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+using namespace std;
+
+
+template <class Product>
+struct INS_GPS2_Runner {
+  typedef typename Product::float_t float_t;
+  typedef typename Product::vec3_t vec3_t;
+  typedef typename Product::mat_t mat_t;
+  Product ins_gps;
+  INS_GPS2_Runner() : ins_gps() {
+    ins_gps.initPosition(M_PI / 180 * 35, M_PI / 180 * 139, 100);
+    ins_gps.initVelocity(1, 2, 3);
+    ins_gps.initAttitude(M_PI / 180 * 10, M_PI / 180 * 5, M_PI / 180 * -3);
+  }
+  void update(const int &i){
+    float_t t(0.01 * i);
+    ins_gps.update(
+        vec3_t(std::sin(t) * 0.1, std::cos(t) * 0.1, -9.8),
+        vec3_t(0.01, std::sin(t) * 0.02, 0.03),
+        0.01);
+  }
+  void correct(){
+    mat_t H(2, Product::P_SIZE), z(2, 1), R(2, 2);
+    H(0, 0) = H(1, 6) = 1;
+    z(0, 0) = 0.5; z(1, 0) = -1;
+    R(0, 0) = 0.1; R(1, 1) = 2;
+    ins_gps.correct_primitive(H, z, R);
+  }
+  /**
+   * @return (double) processing time per update() [ns]
+   */
+  double benchmark(const int &loops){
+    std::clock_t t0(std::clock());
+    for(int i(0); i < loops; ++i){update(i);}
+    return 1E9 * (std::clock() - t0) / CLOCKS_PER_SEC / loops;
+  }
+};
+
+typedef INS_GPS_Factory<> factory_t;
+
+template <class Product_Flexible, class Product_Fixed>
+void check_identical(){
+  typedef typename Product_Flexible::mat_t mat_t;
+  INS_GPS2_Runner<Product_Flexible> flexible;
+  INS_GPS2_Runner<Product_Fixed> fixed;
+  for(int i(0); i < 400; ++i){
+    flexible.update(i);
+    fixed.update(i);
+    if(i % 100 == 99){
+      flexible.correct();
+      fixed.correct();
+    }
+  }
+  mat_t P_flexible(flexible.ins_gps.getFilter().getP());
+  mat_t P_fixed(fixed.ins_gps.getFilter().getP());
+  BOOST_REQUIRE_EQUAL(P_flexible.rows(), P_fixed.rows());
+  for(unsigned int i(0); i < P_flexible.rows(); ++i){
+    for(unsigned int j(0); j < P_flexible.columns(); ++j){
+      BOOST_REQUIRE_SMALL(P_flexible(i, j) - P_fixed(i, j), 1E-8 * (1 + std::abs(P_flexible(i, j))));
+    }
+  }
+  BOOST_CHECK_SMALL(flexible.ins_gps.euler_psi() - fixed.ins_gps.euler_psi(), 1E-10);
+  BOOST_CHECK_SMALL(flexible.ins_gps.latitude() - fixed.ins_gps.latitude(), 1E-10);
+}
+
+template <class Product>
+struct AB_Exposed : public Product {
+  typedef typename Product::getAB_res getAB_res;
+  getAB_res getAB(const typename Product::vec3_t &accel, const typename Product::vec3_t &gyro) const {
+    getAB_res res;
+    Product::getAB(accel, gyro, res);
+    return res;
+  }
+};
+
+template <class Product>
+void check_sparse_predict(){
+  typedef typename Product::float_t float_t;
+  typedef typename Product::vec3_t vec3_t;
+  typedef typename Product::mat_t mat_t;
+  INS_GPS2_Runner<AB_Exposed<Product> > runner;
+  for(int i(0); i < 200; ++i){runner.update(i);}
+
+  float_t dt(0.01);
+  typename AB_Exposed<Product>::getAB_res AB(
+      runner.ins_gps.getAB(vec3_t(0.1, 0.2, -9.8), vec3_t(0.01, 0.02, 0.03)));
+  mat_t Phi(AB.getA() * dt), Gamma(AB.getB() * dt);
+  for(unsigned int i(0); i < Phi.rows(); ++i){Phi(i, i) += 1;}
+  mat_t P(runner.ins_gps.getFilter().getP()), Q(runner.ins_gps.getFilter().getQ());
+
+  mat_t P_dense(Phi * P * Phi.transpose());
+  P_dense += Gamma * Q * Gamma.transpose();
+
+  unsigned int n(Phi.rows()), q(Gamma.columns());
+  mat_t P_sparse(n, n), Phi_P(n, n), Gamma_Q(n, q);
+  KalmanFilter_SparsePredictor::predict(P_sparse, P, Phi, Gamma, Q, Phi_P, Gamma_Q);
+  for(unsigned int i(0); i < n; ++i){
+    for(unsigned int j(0); j < n; ++j){
+      BOOST_REQUIRE_EQUAL(P_dense(i, j), P_sparse(i, j)); // bit-exact
+    }
+  }
+
+  // multiplications; Q is diagonal
+  unsigned int nz_Phi(0), nz_Gamma(0);
+  for(unsigned int i(0); i < n; ++i){
+    for(unsigned int j(0); j < n; ++j){if(Phi(i, j) != 0){++nz_Phi;}}
+    for(unsigned int j(0); j < q; ++j){if(Gamma(i, j) != 0){++nz_Gamma;}}
+  }
+  unsigned int flops_dense(n * n * n * 2 + n * q * q + n * n * q);
+  unsigned int flops_sparse(nz_Phi * n * 2 + nz_Gamma + nz_Gamma * n);
+  BOOST_TEST_MESSAGE("P(" << n << "*" << n << ") multiplications: "
+      << flops_dense << " (dense) => " << flops_sparse << " (sparse)");
+  BOOST_CHECK(flops_sparse * 2 < flops_dense);
+}
+
+template <class Product>
+void check_discretize(){
+  typedef typename Product::float_t float_t;
+  typedef typename Product::vec3_t vec3_t;
+  typedef typename Product::mat_t mat_t;
+  INS_GPS2_Runner<AB_Exposed<Product> > runner;
+  for(int i(0); i < 200; ++i){runner.update(i);}
+
+  float_t dt(0.01);
+  typename AB_Exposed<Product>::getAB_res AB(
+      runner.ins_gps.getAB(vec3_t(0.1, 0.2, -9.8), vec3_t(0.01, 0.02, 0.03)));
+  AB.discretize(dt);
+  mat_t Phi(AB.getA() * dt), Gamma(AB.getB() * dt);
+  for(unsigned int i(0); i < Phi.rows(); ++i){Phi(i, i) += 1;}
+  mat_t Phi2(AB.getPhi()), Gamma2(AB.getGamma()), Phi_inv(AB.getPhi_inv());
+  mat_t Phi_inv_LU(Phi.inverse()), I_dash(Phi_inv * Phi);
+  for(unsigned int i(0); i < Phi.rows(); ++i){
+    for(unsigned int j(0); j < Phi.columns(); ++j){
+      BOOST_REQUIRE_EQUAL(Phi(i, j), Phi2(i, j)); // bit-exact to I + A * dt
+      BOOST_REQUIRE_SMALL(Phi_inv(i, j) - Phi_inv_LU(i, j), 1E-3);
+      BOOST_REQUIRE_SMALL(I_dash(i, j) - ((i == j) ? 1 : 0), 1E-3); // O(dt^2)
+    }
+    for(unsigned int j(0); j < Gamma.columns(); ++j){
+      BOOST_REQUIRE_EQUAL(Gamma(i, j), Gamma2(i, j));
+    }
+  }
+}
+
+template <class Product>
+void check_sequential_correct(){
+  typedef typename Product::mat_t mat_t;
+  INS_GPS2_Runner<Product> runner;
+  for(int i(0); i < 200; ++i){runner.update(i);}
+  mat_t P(runner.ins_gps.getFilter().getP());
+  const unsigned int n(P.rows()), m(6);
+
+  // GPS position and velocity like observation
+  mat_t H(m, n), R(m, m);
+  for(unsigned int i(0); i < m; ++i){
+    H(i, i) = 1;
+    H(i, (i + 7) % n) = 0.5;
+    R(i, i) = 1 + i;
+  }
+
+  static const int loops(200);
+  mat_t K_batch, P_batch;
+  std::clock_t t0(std::clock());
+  for(int i(0); i < loops; ++i){
+    K_batch = P * H.transpose() * ((H * P * H.transpose()) + R).inverse();
+    P_batch = (mat_t::getI(n) - K_batch * H) * P;
+  }
+  std::clock_t t1(std::clock());
+  mat_t K_seq, P_seq;
+  for(int i(0); i < loops; ++i){
+    K_seq = mat_t(n, m);
+    P_seq = P.copy();
+    mat_t P_Ht(n, 1);
+    KalmanFilter_SequentialCorrector::correct(P_seq, H, R, K_seq, P_Ht);
+  }
+  std::clock_t t2(std::clock());
+  BOOST_TEST_MESSAGE("correct(" << n << "*" << n << ", " << m << " obs.): "
+      << 1E9 * (t1 - t0) / CLOCKS_PER_SEC / loops << " (inverse) => "
+      << 1E9 * (t2 - t1) / CLOCKS_PER_SEC / loops << " (sequential) [ns]");
+
+  for(unsigned int i(0); i < n; ++i){
+    for(unsigned int j(0); j < m; ++j){
+      BOOST_REQUIRE_SMALL(K_batch(i, j) - K_seq(i, j), 1E-10 * (1 + std::abs(K_batch(i, j))));
+    }
+    for(unsigned int j(0); j < n; ++j){
+      BOOST_REQUIRE_SMALL(P_batch(i, j) - P_seq(i, j), 1E-10 * (1 + std::abs(P_batch(i, j))));
+    }
+  }
+}
+
+/**
+ * Regression of multi-rate covariance propagation against the propagation at every step.
+ * P and Q are initialized in the same manner as INS_GPS.cpp, and the measurement updates
+ * are performed with small residuals of velocity and height every 1 second.
+ */
+template <class Product>
+void check_multi_rate(const typename Product::float_t &interval){
+  typedef typename Product::mat_t mat_t;
+  INS_GPS2_Runner<Product> every, batch;
+  {
+    mat_t P(every.ins_gps.getFilter().getP()), Q(every.ins_gps.getFilter().getQ());
+    P(0, 0) = P(1, 1) = P(2, 2) = 1E+1;
+    P(3, 3) = P(4, 4) = P(5, 5) = 1E-8;
+    P(6, 6) = 1E+2;
+    P(7, 7) = P(8, 8) = 1E-4;
+    P(9, 9) = 5E-3;
+    Q(0, 0) = Q(1, 1) = Q(2, 2) = 25E-4;
+    Q(3, 3) = Q(4, 4) = Q(5, 5) = 25E-6;
+    Q(6, 6) = 1E-6;
+    for(unsigned int i(10); i < P.rows(); ++i){P(i, i) = 1E-4;} // bias
+    for(unsigned int i(7); i < Q.rows(); ++i){Q(i, i) = 1E-8;}
+    every.ins_gps.getFilter().setP(P);
+    every.ins_gps.getFilter().setQ(Q);
+    batch.ins_gps.getFilter().setP(P.copy());
+    batch.ins_gps.getFilter().setQ(Q.copy());
+  }
+  typename Product::multi_rate_property_t prop;
+  prop.predict_interval = interval;
+  batch.ins_gps.setup_multi_rate(prop);
+
+  static const int loops(2000);
+  mat_t H(4, Product::P_SIZE), z(4, 1), R(4, 4);
+  H(0, 0) = H(1, 1) = H(2, 2) = H(3, 6) = 1;
+  R(0, 0) = R(1, 1) = R(2, 2) = 1E-2;
+  R(3, 3) = 1;
+  std::clock_t t[3];
+  t[0] = std::clock();
+  for(int i(0); i < loops; ++i){
+    every.update(i);
+    if(i % 100 == 99){
+      z(0, 0) = 0.1 * std::sin(0.1 * i); z(1, 0) = 0.1; z(2, 0) = -0.05; z(3, 0) = 0.5;
+      every.ins_gps.correct_primitive(H, z, R);
+    }
+  }
+  t[1] = std::clock();
+  for(int i(0); i < loops; ++i){
+    batch.update(i);
+    if(i % 100 == 99){
+      z(0, 0) = 0.1 * std::sin(0.1 * i); z(1, 0) = 0.1; z(2, 0) = -0.05; z(3, 0) = 0.5;
+      batch.ins_gps.correct_primitive(H, z, R);
+    }
+  }
+  t[2] = std::clock();
+  BOOST_TEST_MESSAGE("predict_interval " << interval << " [s]: "
+      << 1E9 * (t[1] - t[0]) / CLOCKS_PER_SEC / loops << " (every step) => "
+      << 1E9 * (t[2] - t[1]) / CLOCKS_PER_SEC / loops << " (batch) [ns/update]");
+
+  mat_t P_every(every.ins_gps.getFilter().getP()), P_batch(batch.ins_gps.getFilter().getP());
+  for(unsigned int i(0); i < P_every.rows(); ++i){
+    BOOST_CHECK_CLOSE(P_every(i, i), P_batch(i, i), 1); // [%]
+  }
+  BOOST_CHECK_SMALL(every.ins_gps.latitude() - batch.ins_gps.latitude(), 1E-8); // about 6 cm
+  BOOST_CHECK_SMALL(every.ins_gps.longitude() - batch.ins_gps.longitude(), 1E-8);
+  BOOST_CHECK_SMALL(every.ins_gps.height() - batch.ins_gps.height(), 1E-2);
+  BOOST_CHECK_SMALL(every.ins_gps.euler_psi() - batch.ins_gps.euler_psi(), 1E-4);
+  BOOST_CHECK_SMALL(every.ins_gps.euler_theta() - batch.ins_gps.euler_theta(), 1E-4);
+  BOOST_CHECK_SMALL(every.ins_gps.euler_phi() - batch.ins_gps.euler_phi(), 1E-4);
+}
+
+BOOST_AUTO_TEST_SUITE(INS_GPS2_KF)
+
+BOOST_AUTO_TEST_CASE(fixed_kf){
+  check_identical<
+      factory_t::kf<KalmanFilter>::product,
+      factory_t::kf<KalmanFilterFixed>::product>();
+}
+
+BOOST_AUTO_TEST_CASE(fixed_kf_bias){
+  check_identical<
+      factory_t::bias<>::kf<KalmanFilter>::product,
+      factory_t::bias<>::kf<KalmanFilterFixed>::product>();
+}
+
+BOOST_AUTO_TEST_CASE(symmetric_kf){
+  check_identical<
+      factory_t::kf<KalmanFilter>::product,
+      factory_t::kf<KalmanFilterSymmetric>::product>();
+  check_identical<
+      factory_t::kf<KalmanFilter>::product,
+      factory_t::kf<KalmanFilterJoseph>::product>();
+}
+
+BOOST_AUTO_TEST_CASE(symmetric_kf_bias){
+  check_identical<
+      factory_t::bias<>::kf<KalmanFilter>::product,
+      factory_t::bias<>::kf<KalmanFilterSymmetric>::product>();
+  check_identical<
+      factory_t::bias<>::kf<KalmanFilter>::product,
+      factory_t::bias<>::kf<KalmanFilterJoseph>::product>();
+}
+
+BOOST_AUTO_TEST_CASE(symmetric_kf_symmetry){
+  typedef factory_t::kf<KalmanFilterJoseph>::product product_t;
+  typedef product_t::mat_t mat_t;
+  INS_GPS2_Runner<product_t> runner;
+  for(int i(0); i < 400; ++i){
+    runner.update(i);
+    if(i % 10 == 9){runner.correct();}
+  }
+  mat_t P(runner.ins_gps.getFilter().getP());
+  BOOST_CHECK(P.isSymmetric()); // exactly
+  for(unsigned int i(0); i < P.rows(); ++i){
+    BOOST_CHECK(P(i, i) > 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(sequential_correct){
+  check_sequential_correct<factory_t::product>();
+}
+
+BOOST_AUTO_TEST_CASE(sequential_correct_bias){
+  check_sequential_correct<factory_t::bias<>::product>();
+}
+
+BOOST_AUTO_TEST_CASE(sparse_predict){
+  check_sparse_predict<factory_t::product>();
+}
+
+BOOST_AUTO_TEST_CASE(sparse_predict_bias){
+  check_sparse_predict<factory_t::bias<>::product>();
+}
+
+BOOST_AUTO_TEST_CASE(discretize){
+  check_discretize<factory_t::kf<KalmanFilter>::product>();
+  check_discretize<factory_t::bias<>::kf<KalmanFilter>::product>();
+}
+
+BOOST_AUTO_TEST_CASE(multi_rate){
+  check_multi_rate<factory_t::product>(0.05);
+  check_multi_rate<factory_t::bias<>::product>(0.05);
+  check_multi_rate<factory_t::bias<>::kf<KalmanFilterFixed>::product>(0.1);
+}
+
+BOOST_AUTO_TEST_CASE(update_time){
+  static const int loops(2000);
+  BOOST_TEST_MESSAGE("KF: "
+      << INS_GPS2_Runner<factory_t::kf<KalmanFilter>::product>().benchmark(loops)
+      << " [ns/update]");
+  BOOST_TEST_MESSAGE("KF(fixed): "
+      << INS_GPS2_Runner<factory_t::kf<KalmanFilterFixed>::product>().benchmark(loops)
+      << " [ns/update]");
+  BOOST_TEST_MESSAGE("KF(symmetric): "
+      << INS_GPS2_Runner<factory_t::kf<KalmanFilterSymmetric>::product>().benchmark(loops)
+      << " [ns/update]");
+  BOOST_TEST_MESSAGE("KF with bias: "
+      << INS_GPS2_Runner<factory_t::bias<>::kf<KalmanFilter>::product>().benchmark(loops)
+      << " [ns/update]");
+  BOOST_TEST_MESSAGE("KF(fixed) with bias: "
+      << INS_GPS2_Runner<factory_t::bias<>::kf<KalmanFilterFixed>::product>().benchmark(loops)
+      << " [ns/update]");
+  BOOST_TEST_MESSAGE("KF with EGM: "
+      << INS_GPS2_Runner<factory_t::egm<>::kf<KalmanFilter>::product>().benchmark(loops)
+      << " [ns/update]");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(Synchronization)
+
+template <class Product>
+void check_back_propagate(){
+  typedef INS_GPS_Back_Propagate<Product> bp_t;
+  typedef typename Product::float_t float_t;
+  typedef typename Product::mat_t mat_t;
+  typedef typename bp_t::snapshot_content_t snapshot_t;
+  INS_GPS2_Runner<bp_t> runner;
+  {
+    INS_GPS_Back_Propagate_Property<float_t> prop;
+    prop.back_propagate_depth = -0.5;
+    runner.ins_gps.setup_back_propagation(prop);
+  }
+  unsigned int capacity(runner.ins_gps.get_snapshots().capacity());
+  for(int i(0); i < 1000; ++i){
+    if(i % 100 != 99){
+      runner.update(i);
+      continue;
+    }
+
+    // The whole object before the time update, which was formerly stored as a snapshot
+    Product ref(runner.ins_gps, true);
+    runner.update(i);
+
+    const typename bp_t::snapshots_t &snapshots(runner.ins_gps.get_snapshots());
+    {
+      const Product &restored(runner.ins_gps.restore_snapshot(snapshots.size() - 1));
+      for(unsigned int j(0); j < Product::STATE_VALUES; ++j){
+        BOOST_REQUIRE_EQUAL(restored[j], ref[j]);
+      }
+    }
+    snapshot_t latest(snapshots.back(), true);
+
+    mat_t H(2, Product::P_SIZE), z(2, 1), R(2, 2);
+    H(0, 0) = H(1, 6) = 1;
+    z(0, 0) = 0.5; z(1, 0) = -1;
+    R(0, 0) = 0.1; R(1, 1) = 2;
+    runner.ins_gps.correct_primitive(H, z, R);
+
+    // Back propagation with the whole object
+    ref.getFilter().setP(latest.P.copy());
+    ref.correct_primitive(H * latest.Phi, z, R + H * latest.GQGt * H.transpose());
+
+    BOOST_REQUIRE(!snapshots.empty());
+    const Product &restored(runner.ins_gps.restore_snapshot(snapshots.size() - 1));
+    for(unsigned int j(0); j < Product::STATE_VALUES; ++j){
+      BOOST_CHECK_SMALL(restored[j] - ref[j], 1E-12);
+    }
+    mat_t P_restored(const_cast<Product &>(restored).getFilter().getP());
+    mat_t P_ref(ref.getFilter().getP());
+    for(unsigned int j(0); j < P_ref.rows(); ++j){
+      for(unsigned int k(0); k < P_ref.columns(); ++k){
+        BOOST_CHECK_SMALL(P_restored(j, k) - P_ref(j, k), 1E-12);
+      }
+    }
+
+    // bounded by the depth, 0.5 [s], and the interval of correction, 1 [s]
+    BOOST_CHECK(snapshots.size() <= 151);
+  }
+  BOOST_CHECK_EQUAL(runner.ins_gps.get_snapshots().capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(back_propagate){
+  check_back_propagate<factory_t::product>();
+  check_back_propagate<factory_t::bias<>::product>();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ConingSculling)
+
+struct coning_motion_t {
+  // coning (A [rad] at W [rad/s]) and sculling (B [m/s^2]) motion
+  static const double A, W, B;
+  typedef INS<double> ins_t;
+  typedef ins_t::vec3_t vec3_t;
+  /**
+   * @return mean angular speed in the interval [t, t + dt]
+   */
+  static vec3_t gyro(const double &t, const double &dt){
+    return vec3_t(
+        A * (std::sin(W * (t + dt)) - std::sin(W * t)) / dt,
+        -A * (std::cos(W * (t + dt)) - std::cos(W * t)) / dt,
+        0.01);
+  }
+  /**
+   * @return mean acceleration in the interval [t, t + dt]
+   */
+  static vec3_t accel(const double &t, const double &dt){
+    return vec3_t(
+        0.1,
+        B * (std::sin(W * (t + dt)) - std::sin(W * t)) / (W * dt),
+        -9.8);
+  }
+  template <class INS_T>
+  static void run(INS_T &ins, const double &dt, const double &T){
+    ins.initPosition(M_PI / 180 * 35, M_PI / 180 * 139, 100);
+    ins.initVelocity(1, 2, 0);
+    ins.initAttitude(0.1, 0.05, -0.03);
+    for(int i(0), steps(std::floor(T / dt + 0.5)); i < steps; ++i){
+      ins.update(accel(dt * i, dt), gyro(dt * i, dt), dt);
+    }
+  }
+};
+const double coning_motion_t::A = 0.02;
+const double coning_motion_t::W = M_PI * 2 * 5;
+const double coning_motion_t::B = 0.5;
+
+BOOST_AUTO_TEST_CASE(accuracy){
+  typedef coning_motion_t::ins_t ins_t;
+  static const double T(5), dt(1E-2);
+  ins_t ref, base;
+  coning_motion_t::run(ref, 1E-5, T);
+  coning_motion_t::run(base, dt, T);
+
+  INS_ConingSculling<ins_t> cs;
+  INS_ConingSculling_Property<double> prop;
+  prop.major_interval = 0.02 - 1E-9; // two samples per major update
+  cs.setup_coning_sculling(prop);
+  coning_motion_t::run(cs, dt, T);
+
+  BOOST_TEST_MESSAGE("psi error: "
+      << (base.euler_psi() - ref.euler_psi()) << " (base) => "
+      << (cs.euler_psi() - ref.euler_psi()) << " (coning/sculling)");
+  BOOST_TEST_MESSAGE("v_north error: "
+      << (base.v_north() - ref.v_north()) << " (base) => "
+      << (cs.v_north() - ref.v_north()) << " (coning/sculling)");
+  BOOST_TEST_MESSAGE("height error: "
+      << (base.height() - ref.height()) << " (base) => "
+      << (cs.height() - ref.height()) << " (coning/sculling)");
+  BOOST_CHECK(std::abs(cs.euler_psi() - ref.euler_psi())
+      < std::abs(base.euler_psi() - ref.euler_psi()) / 10);
+  BOOST_CHECK(std::abs(cs.euler_theta() - ref.euler_theta())
+      < std::abs(base.euler_theta() - ref.euler_theta()));
+  BOOST_CHECK(std::abs(cs.euler_phi() - ref.euler_phi())
+      < std::abs(base.euler_phi() - ref.euler_phi()));
+  BOOST_CHECK(std::abs(cs.v_north() - ref.v_north())
+      < std::abs(base.v_north() - ref.v_north()));
+  BOOST_CHECK(std::abs(cs.height() - ref.height())
+      < std::abs(base.height() - ref.height()));
+}
+
+BOOST_AUTO_TEST_CASE(filtered){
+  typedef factory_t::coning_sculling<>::product product_t;
+  typedef product_t::mat_t mat_t;
+  INS_GPS2_Runner<product_t> runner;
+  for(int i(0); i < 400; ++i){
+    runner.update(i);
+    if(i % 100 == 99){runner.correct();}
+  }
+  mat_t P(runner.ins_gps.getFilter().getP());
+  for(unsigned int i(0); i < P.rows(); ++i){
+    BOOST_CHECK(P(i, i) > 0);
+  }
+  BOOST_TEST_MESSAGE("KF with coning/sculling: "
+      << INS_GPS2_Runner<product_t>().benchmark(2000)
+      << " [ns/update]");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(Attitude)
+
+typedef Quaternion<double> quat_t;
+typedef Vector3<double> vec3_t;
+
+BOOST_AUTO_TEST_CASE(value_storage){
+  quat_t q(0.5, 0.1, -0.7, 0.3), q2(q);
+  q2[1] = 2;
+  BOOST_CHECK_EQUAL(q[1], 0.1); // deep copy by default
+  vec3_t v(1, 2, 3), v2(v);
+  q.vector()[0] = 3;
+  v2[0] = 4;
+  BOOST_CHECK_EQUAL(v[0], 1);
+  BOOST_CHECK_EQUAL(q2.vector()[0], 2);
+}
+
+BOOST_AUTO_TEST_CASE(product_and_rotate){
+  quat_t qa(0.5, 0.1, -0.7, 0.3), qb(-0.2, 0.8, 0.4, -0.6);
+  vec3_t v(1, -2, 3);
+  { // definition: {q0a q0b - qa . qb, q0a qb + q0b qa + qa x qb}
+    quat_t qab(qa * qb);
+    vec3_t vec_ab((qb.vector() * qa.scalar()) + (qa.vector() * qb.scalar())
+        + (qa.vector() * qb.vector()));
+    BOOST_CHECK_SMALL(qab.scalar() - (qa.scalar() * qb.scalar() - qa.vector().innerp(qb.vector())), 1E-15);
+    for(int i(0); i < 3; ++i){
+      BOOST_CHECK_SMALL(qab.vector()[i] - vec_ab[i], 1E-15);
+    }
+  }
+  { // rotate() equals to product form, even if norm is not one
+    vec3_t v_rot(qa.rotate(v)), v_rot2((qa * v * qa.conj()).vector());
+    vec3_t v_inv(qa.conj().rotate(v)), v_inv2((qa.conj() * v * qa).vector());
+    for(int i(0); i < 3; ++i){
+      BOOST_CHECK_SMALL(v_rot[i] - v_rot2[i], 1E-14);
+      BOOST_CHECK_SMALL(v_inv[i] - v_inv2[i], 1E-14);
+    }
+  }
+}
+
+template <class Product>
+struct RotationCache_Exposed : public Product {
+  void check() const {
+    typedef typename Product::mat_t mat_t;
+    const typename Product::rotation_cache_t &cache(this->rotation_cache);
+    mat_t dcm_e2n(this->q_e2n.getDCM()), dcm_n2b(this->q_n2b.getDCM());
+    for(int i(0); i < 3; ++i){
+      for(int j(0); j < 3; ++j){
+        BOOST_REQUIRE_SMALL(cache.dcm_e2n[i][j] - dcm_e2n(i, j), 1E-14);
+        BOOST_REQUIRE_SMALL(cache.dcm_n2b[i][j] - dcm_n2b(i, j), 1E-14);
+      }
+    }
+    BOOST_REQUIRE_SMALL(cache.sin_phi - std::sin(this->phi), 1E-14);
+    BOOST_REQUIRE_SMALL(cache.cos_phi - std::cos(this->phi), 1E-14);
+    BOOST_REQUIRE_SMALL(cache.sin_lambda - std::sin(this->lambda), 1E-14);
+    BOOST_REQUIRE_SMALL(cache.cos_lambda - std::cos(this->lambda), 1E-14);
+    BOOST_REQUIRE_SMALL(cache.sin_alpha - std::sin(this->alpha), 1E-14);
+    BOOST_REQUIRE_SMALL(cache.cos_alpha - std::cos(this->alpha), 1E-14);
+  }
+};
+
+BOOST_AUTO_TEST_CASE(rotation_cache){
+  typedef RotationCache_Exposed<factory_t::kf<KalmanFilter>::product> product_t;
+  INS_GPS2_Runner<product_t> runner;
+  runner.ins_gps.check();
+  for(int i(0); i < 400; ++i){
+    runner.update(i);
+    if(i % 100 == 99){runner.correct();}
+    runner.ins_gps.check();
+  }
+  runner.ins_gps.mod_euler_psi(0.1);
+  runner.ins_gps.check();
+  runner.ins_gps.mod_euler_theta(-0.05);
+  runner.ins_gps.check();
+  runner.ins_gps.mod_euler_phi(0.2);
+  runner.ins_gps.check();
+  runner.ins_gps.initAttitude(quat_t(0.5, 0.1, -0.7, 0.3).regularize());
+  runner.ins_gps.check();
+  runner.ins_gps.initPosition(-M_PI / 2, 0.5, 10); // south pole
+  runner.ins_gps.check();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(EGM)
+
+BOOST_AUTO_TEST_CASE(gravity_cache){
+  typedef EGM_GravityCache<EGM2008_70> cache_t;
+  cache_t cache(100);
+  const double r0(WGS84::R_e + 100), phi0(M_PI / 180 * 35), lambda0(M_PI / 180 * 139);
+  int hits(0);
+  for(int i(0); i < 400; ++i){
+    // spiral path whose step is 1 m horizontally and 0.5 m vertically
+    double t(0.01 * i);
+    double r(r0 + 0.5 * i),
+        phi(phi0 + 100 * std::sin(t) / r0),
+        lambda(lambda0 + i / (r0 * std::cos(phi0)));
+    if(cache.hit(r, phi, lambda)){++hits;}
+    EGM2008_70::gravity_res_t
+        g_cache(cache.gravity(r, phi, lambda)),
+        g_direct(EGM2008_70::gravity(r, phi, lambda));
+    BOOST_REQUIRE_SMALL(g_cache.r - g_direct.r, 1E-6);
+    BOOST_REQUIRE_SMALL(g_cache.phi - g_direct.phi, 1E-6);
+    BOOST_REQUIRE_SMALL(g_cache.lambda - g_direct.lambda, 1E-6);
+  }
+  BOOST_CHECK(hits > 300);
+
+  cache.tolerance = 0;
+  BOOST_CHECK(!cache.hit(cache.r0, cache.phi0, cache.lambda0));
+}
+
+BOOST_AUTO_TEST_CASE(gravity_time){
+  static const int loops(2000);
+  const double r0(WGS84::R_e + 100), phi0(M_PI / 180 * 35), lambda0(M_PI / 180 * 139);
+  double sum(0);
+  std::clock_t t0(std::clock());
+  for(int i(0); i < loops; ++i){
+    sum += EGM2008_70::gravity(r0 + i, phi0, lambda0).r;
+  }
+  std::clock_t t1(std::clock());
+  EGM_GravityCache<EGM2008_70> cache(100);
+  for(int i(0); i < loops; ++i){
+    sum += cache.gravity(r0 + 0.01 * i, phi0, lambda0).r;
+  }
+  std::clock_t t2(std::clock());
+  BOOST_TEST_MESSAGE("EGM: "
+      << (1E9 / CLOCKS_PER_SEC * (t1 - t0) / loops) << " [ns/call]");
+  BOOST_TEST_MESSAGE("EGM(cached): "
+      << (1E9 / CLOCKS_PER_SEC * (t2 - t1) / loops) << " [ns/call]");
+
+  typedef EGM_Grid<EGM2008_70> grid_egm_t;
+  grid_egm_t::header_t spec;
+  spec.origin[0] = phi0 - 0.001;
+  spec.origin[1] = lambda0 - 0.001;
+  spec.origin[2] = r0 - grid_egm_t::radius_ellipsoid(std::cos(phi0)) - 100;
+  spec.step[0] = spec.step[1] = 0.001;
+  spec.step[2] = 500;
+  spec.num[0] = spec.num[1] = spec.num[2] = 3;
+  grid_egm_t::grid_t grid(spec);
+  grid.activate();
+  std::clock_t t3(std::clock());
+  for(int i(0); i < loops; ++i){
+    sum += grid_egm_t::gravity(r0 + 0.01 * i, phi0, lambda0).r;
+  }
+  std::clock_t t4(std::clock());
+  BOOST_TEST_MESSAGE("EGM(grid): "
+      << (1E9 / CLOCKS_PER_SEC * (t4 - t3) / loops) << " [ns/call]");
+  BOOST_CHECK(sum < 0);
+}
+
+BOOST_AUTO_TEST_CASE(gravity_grid){
+  typedef EGM_Grid<EGM2008_70> grid_egm_t;
+  static const char *fname("test_INS_GPS2_grid.egm");
+  grid_egm_t::header_t spec;
+  spec.origin[0] = M_PI / 180 * 34.8;
+  spec.origin[1] = M_PI / 180 * 138.8;
+  spec.origin[2] = -200;
+  spec.step[0] = spec.step[1] = M_PI / 180 * 0.05;
+  spec.step[2] = 200;
+  spec.num[0] = spec.num[1] = 9;
+  spec.num[2] = 6;
+  {
+    grid_egm_t::grid_t grid(spec);
+    for(int i(0); i < 3; ++i){
+      BOOST_REQUIRE(grid.header->max_error[i] > 0);
+      BOOST_REQUIRE(grid.header->max_error[i] < 1E-5);
+    }
+    std::ofstream out(fname, std::ios::out | std::ios::binary);
+    grid.save(out);
+  }
+
+  {
+    grid_egm_t::grid_t grid(fname);
+    BOOST_REQUIRE(grid.header->is_valid());
+    grid.activate();
+    std::srand(0);
+    for(int i(0); i < 200; ++i){
+      double
+          phi(spec.origin[0] + spec.step[0] * (spec.num[0] - 1) * std::rand() / RAND_MAX),
+          lambda(spec.origin[1] + spec.step[1] * (spec.num[1] - 1) * std::rand() / RAND_MAX),
+          r(grid_egm_t::radius_ellipsoid(std::cos(phi))
+            + spec.origin[2] + spec.step[2] * (spec.num[2] - 1) * std::rand() / RAND_MAX);
+      EGM2008_70::gravity_res_t
+          g_grid(grid_egm_t::gravity(r, phi, lambda)),
+          g_direct(EGM2008_70::gravity(r, phi, lambda));
+      // cell center estimation is not a strict bound, then a margin is given.
+      BOOST_REQUIRE_SMALL(g_grid.r - g_direct.r, grid.header->max_error[0] * 2 + 1E-6);
+      BOOST_REQUIRE_SMALL(g_grid.phi - g_direct.phi, grid.header->max_error[1] * 2 + 1E-6);
+      BOOST_REQUIRE_SMALL(g_grid.lambda - g_direct.lambda, grid.header->max_error[2] * 2 + 1E-6);
+    }
+
+    // outside of the grid
+    double r(WGS84::R_e), phi(0), lambda(0);
+    EGM2008_70::gravity_res_t
+        g_grid(grid_egm_t::gravity(r, phi, lambda)),
+        g_direct(EGM2008_70::gravity(r, phi, lambda));
+    BOOST_CHECK_EQUAL(g_grid.r, g_direct.r);
+    BOOST_CHECK_EQUAL(g_grid.phi, g_direct.phi);
+    BOOST_CHECK_EQUAL(g_grid.lambda, g_direct.lambda);
+  }
+  BOOST_CHECK(grid_egm_t::current() == NULL);
+  std::remove(fname);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
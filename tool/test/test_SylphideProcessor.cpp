@@ -0,0 +1,482 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#define IS_LITTLE_ENDIAN 1
+#include "SylphideProcessor.h"
+#include "SylphideStream.h"
+#include "SylphideLogIndex.h"
+#include "util/mapped_file.h"
+#include "util/crc.cpp" // linked directly, because tests do not share objects
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+using namespace std;
+
+static const char *log_fname = "test_SylphideProcessor.dat";
+
+struct Fixture {
+  static const int pages = 0x10000;
+  Fixture(){
+    std::srand(0);
+    ofstream out(log_fname, ios::out | ios::binary);
+    char page[SYLPHIDE_PAGE_SIZE];
+    for(int i(0); i < pages; ++i){
+      page[0] = 'A';
+      for(int j(1); j < SYLPHIDE_PAGE_SIZE; ++j){
+        page[j] = (char)(std::rand() & 0xFF);
+      }
+      out.write(page, sizeof(page));
+    }
+  }
+  ~Fixture(){
+    std::remove(log_fname);
+  }
+};
+
+template <class Observer>
+struct Processor : public AbstractSylphideProcessor<double> {
+  struct result_t {
+    unsigned int itow_ms;
+    A_Packet_Observer<>::values_t values;
+  };
+  struct Handler {
+    vector<result_t> results;
+    void operator()(const Observer &observer){
+      if(!observer.validate()){return;}
+      result_t res = {observer.fetch_ITOW_ms(), observer.fetch_values()};
+      results.push_back(res);
+    }
+  } handler;
+  Observer observer;
+  bool previous_seek_next;
+  Processor()
+      : handler(), observer(SYLPHIDE_PAGE_SIZE * 0x100),
+      previous_seek_next(observer.ready()) {}
+  void process(const char *page, const int &size){
+    process_packet(page, size, observer, previous_seek_next, handler);
+  }
+  void process(istream &in){
+    char buffer[SYLPHIDE_PAGE_SIZE];
+    while(true){
+      in.read(buffer, sizeof(buffer));
+      if(in.fail() || (in.gcount() == 0)){break;}
+      process(buffer, (int)in.gcount());
+    }
+  }
+  void process(const MappedFile &in){
+    MappedFile::page_reader_t pages(in.pages(SYLPHIDE_PAGE_SIZE));
+    const char *buffer;
+    while(pages.next(buffer) == SYLPHIDE_PAGE_SIZE){
+      process(buffer, SYLPHIDE_PAGE_SIZE);
+    }
+  }
+};
+
+/**
+ * A page observer which always copies pages into FIFO, i.e., the previous behavior.
+ */
+struct FIFO_A_Observer : public A_Packet_Observer<> {
+  static const unsigned int direct_packet_size = 0;
+  FIFO_A_Observer(const unsigned int &buffer_size)
+      : A_Packet_Observer<>(buffer_size) {}
+};
+
+BOOST_FIXTURE_TEST_SUITE(Sylphide, Fixture)
+
+BOOST_AUTO_TEST_CASE(direct_observation){
+  Processor<FIFO_A_Observer> proc_fifo;
+  {
+    ifstream in(log_fname, ios::in | ios::binary);
+    proc_fifo.process(in);
+  }
+
+  Processor<A_Packet_Observer<> > proc_direct;
+  {
+    MappedFile in(log_fname);
+    BOOST_REQUIRE_EQUAL(in.size(), (size_t)(pages * SYLPHIDE_PAGE_SIZE));
+    proc_direct.process(in);
+  }
+  BOOST_CHECK(proc_direct.observer.is_empty());
+
+  BOOST_REQUIRE_EQUAL(proc_fifo.handler.results.size(), (size_t)pages);
+  BOOST_REQUIRE_EQUAL(proc_direct.handler.results.size(), (size_t)pages);
+  for(int i(0); i < pages; ++i){
+    BOOST_REQUIRE_EQUAL(
+        proc_fifo.handler.results[i].itow_ms,
+        proc_direct.handler.results[i].itow_ms);
+    for(int j(0); j < 8; ++j){
+      BOOST_REQUIRE_EQUAL(
+          proc_fifo.handler.results[i].values.values[j],
+          proc_direct.handler.results[i].values.values[j]);
+    }
+    BOOST_REQUIRE_EQUAL(
+        proc_fifo.handler.results[i].values.temperature,
+        proc_direct.handler.results[i].values.temperature);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(truncated_page){
+  // After a truncated page, FIFO must be used until it becomes empty again.
+  Processor<FIFO_A_Observer> proc_fifo;
+  Processor<A_Packet_Observer<> > proc_direct;
+  MappedFile in(log_fname);
+  const char *head(in.data());
+  static const int sizes[] = {
+    SYLPHIDE_PAGE_SIZE, 10, SYLPHIDE_PAGE_SIZE, 23, SYLPHIDE_PAGE_SIZE,
+    20, 13, SYLPHIDE_PAGE_SIZE, SYLPHIDE_PAGE_SIZE};
+  for(unsigned int i(0); i < sizeof(sizes) / sizeof(sizes[0]); ++i){
+    proc_fifo.process(head, sizes[i]);
+    proc_direct.process(head, sizes[i]);
+    head += SYLPHIDE_PAGE_SIZE;
+    BOOST_REQUIRE_EQUAL(
+        proc_fifo.handler.results.size(),
+        proc_direct.handler.results.size());
+    BOOST_REQUIRE_EQUAL(proc_fifo.observer.stored(), proc_direct.observer.stored());
+    if(proc_fifo.handler.results.empty()){continue;}
+    BOOST_REQUIRE_EQUAL(
+        proc_fifo.handler.results.back().itow_ms,
+        proc_direct.handler.results.back().itow_ms);
+  }
+  BOOST_CHECK(proc_direct.observer.is_empty());
+}
+
+BOOST_AUTO_TEST_CASE(pages_per_second){
+  static const int loops(8);
+  double pps[2];
+  {
+    std::clock_t t0(std::clock());
+    for(int i(0); i < loops; ++i){
+      Processor<FIFO_A_Observer> proc;
+      ifstream in(log_fname, ios::in | ios::binary);
+      proc.process(in);
+    }
+    pps[0] = (double)pages * loops * CLOCKS_PER_SEC / (std::clock() - t0 + 1);
+  }
+  {
+    std::clock_t t0(std::clock());
+    for(int i(0); i < loops; ++i){
+      Processor<A_Packet_Observer<> > proc;
+      MappedFile in(log_fname);
+      proc.process(in);
+    }
+    pps[1] = (double)pages * loops * CLOCKS_PER_SEC / (std::clock() - t0 + 1);
+  }
+  BOOST_TEST_MESSAGE("istream + FIFO: " << pps[0] << " [pages/s]");
+  BOOST_TEST_MESSAGE("mmap + direct: " << pps[1] << " [pages/s]");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LogIndex)
+
+/**
+ * Log consisting of A pages at 100 Hz, and G pages of NAV-SOL, which gives GPS week.
+ */
+struct IndexedLog {
+  static const int week = 2000;
+  static const int pages_A = 0x1000;
+  static const unsigned int itow_ms_0 = 300000000;
+  vector<char> data;
+  IndexedLog() : data() {
+    char page[SYLPHIDE_PAGE_SIZE] = {0};
+    for(int i(0); i < pages_A; ++i){
+      if(i == 10){ // NAV-SOL
+        unsigned char packet[8 + 52] = {0xB5, 0x62, 0x01, 0x06, 52, 0};
+        packet[6 + 8] = (unsigned char)(week & 0xFF);
+        packet[6 + 9] = (unsigned char)(week >> 8);
+        packet[6 + 11] = 0x04; // WN_VALID
+        unsigned char ck_a(0), ck_b(0);
+        for(unsigned int j(2); j < sizeof(packet) - 2; ++j){
+          ck_a += packet[j];
+          ck_b += ck_a;
+        }
+        packet[sizeof(packet) - 2] = ck_a;
+        packet[sizeof(packet) - 1] = ck_b;
+        for(unsigned int j(0); j < sizeof(packet); j += (SYLPHIDE_PAGE_SIZE - 1)){
+          std::memset(page, 0, sizeof(page));
+          page[0] = 'G';
+          for(unsigned int k(0); (k < SYLPHIDE_PAGE_SIZE - 1) && (j + k < sizeof(packet)); ++k){
+            page[k + 1] = (char)packet[j + k];
+          }
+          data.insert(data.end(), page, page + sizeof(page));
+        }
+      }
+      unsigned int itow_ms(itow_ms_0 + 10 * i);
+      page[0] = 'A';
+      for(int j(0); j < 4; ++j){page[2 + j] = (char)((itow_ms >> (8 * j)) & 0xFF);}
+      data.insert(data.end(), page, page + sizeof(page));
+    }
+  }
+  unsigned int pages() const {return (unsigned int)(data.size() / SYLPHIDE_PAGE_SIZE);}
+};
+
+struct TimeRange {
+  double start, end; // [s]
+  int week;
+  double gpst(const double &sec, const int &wn) const {
+    return (wn < 0) ? -1 : ((double)wn * 604800 + sec);
+  }
+  bool is_time_after_start(const double &sec, const int &wn) const {
+    return gpst(sec, wn) >= gpst(start, week);
+  }
+  bool is_time_before_end(const double &sec, const int &wn) const {
+    return (wn < 0) || (gpst(sec, wn) <= gpst(end, week));
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(generate_and_seek, IndexedLog){
+  SylphideLogIndex index;
+  {
+    SylphideLogIndex::Generator<> generator(index, 0x10);
+    for(unsigned int i(0); i < pages(); ++i){
+      generator.process(&data[SYLPHIDE_PAGE_SIZE * i]);
+    }
+  }
+  {
+    stringstream ss;
+    index.save(ss);
+    SylphideLogIndex loaded;
+    BOOST_REQUIRE(loaded.load(ss));
+    BOOST_REQUIRE_EQUAL(loaded.entries.size(), index.entries.size());
+    index = loaded;
+  }
+  BOOST_REQUIRE_EQUAL(index.header.pages, pages());
+  BOOST_REQUIRE_EQUAL(index.entries.size(), (pages() + 0xF) / 0x10);
+
+  for(unsigned int i(0); i < index.entries.size(); ++i){
+    const SylphideLogIndex::entry_t &entry(index.entries[i]);
+    BOOST_REQUIRE_EQUAL(entry.page, i * 0x10);
+    BOOST_REQUIRE_EQUAL(entry.type, data[SYLPHIDE_PAGE_SIZE * entry.page]);
+    if(entry.page == 0){ // no time stamp before the first page
+      BOOST_REQUIRE(entry.itow < 0);
+      continue;
+    }
+    unsigned int itow_ms(0);
+    int week(-1);
+    for(unsigned int j(0); j < entry.page; ++j){ // the latest time stamp and week
+      const char *page(&data[SYLPHIDE_PAGE_SIZE * j]);
+      if(page[0] == 'A'){
+        itow_ms = (unsigned int)(unsigned char)page[2]
+            | ((unsigned int)(unsigned char)page[3] << 8)
+            | ((unsigned int)(unsigned char)page[4] << 16)
+            | ((unsigned int)(unsigned char)page[5] << 24);
+      }else{
+        week = IndexedLog::week;
+      }
+    }
+    BOOST_REQUIRE_CLOSE(entry.itow, 1E-3 * itow_ms, 1E-9);
+    BOOST_REQUIRE_EQUAL(entry.week, week);
+  }
+
+  TimeRange range = {1E-3 * itow_ms_0 + 20, 1E-3 * itow_ms_0 + 25, IndexedLog::week};
+  unsigned int start(index.start_page(range)), end(index.end_page(range));
+  BOOST_REQUIRE(start < end);
+  BOOST_REQUIRE(end < pages());
+
+  // Time stamps of [start, end) pages should cover the range with margins.
+  const double itow_start(1E-3 * (itow_ms_0 + 10 * (start - 2))); // 2 G pages
+  const double itow_end(1E-3 * (itow_ms_0 + 10 * (end - 2)));
+  BOOST_CHECK(itow_start <= range.start - index.margin);
+  BOOST_CHECK(itow_start > range.start - index.margin - 0.16 - 0.01); // at most one interval earlier
+  BOOST_CHECK(itow_end > range.end + index.margin);
+  BOOST_CHECK(itow_end < range.end + index.margin + 0.16 + 0.01);
+
+  // Range in the next week, which requires the whole log
+  range.week = IndexedLog::week + 1;
+  BOOST_CHECK_EQUAL(index.start_page(range), index.entries.back().page);
+  BOOST_CHECK_EQUAL(index.end_page(range), pages());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(SylphideStream)
+
+static const unsigned int payload_length = SylphideProtocol::payload_fixed_length;
+
+BOOST_AUTO_TEST_CASE(crc16_sliced){
+  std::srand(0);
+  unsigned char buf[0x100];
+  for(unsigned int i(0); i < sizeof(buf); ++i){
+    buf[i] = (unsigned char)(std::rand() & 0xFF);
+  }
+  for(int offset(0); offset < 8; ++offset){
+    for(int size(0); size <= (int)sizeof(buf) - offset; ++size){
+      Uint16 crc_bytewise(0x1234);
+      for(int i(0); i < size; ++i){
+        crc_bytewise = CRC16::crc16_generic(buf[offset + i], crc_bytewise);
+      }
+      BOOST_REQUIRE_EQUAL(crc_bytewise, CRC16::crc16(&buf[offset], size, 0x1234));
+    }
+  }
+}
+
+/**
+ * Generate Sylphide packets, some of which are corrupted or preceded by garbage.
+ *
+ * @param packets number of packets
+ * @param expected payloads of packets which should be decoded
+ */
+static std::string generate_sylphide_stream(
+    const int &packets, std::vector<std::string> *expected = NULL){
+  std::string res;
+  char packet[0x40];
+  const unsigned int packet_size(
+      SylphideProtocol::Encoder::packet_size(payload_length));
+  for(int i(0); i < packets; ++i){
+    if((std::rand() & 0xF) == 0){
+      // Garbage, which may contain fake headers of fixed length.
+      // A fake header of variable length is excluded because it may request
+      // bytes beyond the end of the stream, which suspends decoding.
+      for(int j(std::rand() % 40); j > 0; --j){
+        char c((char)(std::rand() & 0xFF));
+        if((std::rand() & 0x3) == 0){
+          res.push_back((char)SylphideProtocol::header[0]);
+          c = (char)SylphideProtocol::header[1];
+        }else if(c == (char)SylphideProtocol::header[0]){
+          continue;
+        }
+        res.push_back(c);
+      }
+    }
+    unsigned int offset(SylphideProtocol::Encoder::preprocess(packet, payload_length));
+    for(unsigned int j(0); j < payload_length; ++j){
+      packet[offset + j] = (char)(std::rand() & 0xFF);
+    }
+    SylphideProtocol::Encoder::postprocess(packet, i, packet_size);
+    if((std::rand() & 0xF) == 0){ // corruption of sequence number, payload, or CRC
+      packet[SylphideProtocol::header_size
+          + (std::rand() % (packet_size - SylphideProtocol::header_size))]
+          ^= (char)(1 << (std::rand() % 8));
+    }else if(expected){
+      expected->push_back(std::string(&packet[offset], payload_length));
+    }
+    res.append(packet, packet_size);
+  }
+  return res;
+}
+
+/**
+ * Reference decoder, which processes a character at a time in the same way as
+ * the former implementation of basic_SylphideStreambuf_in.
+ */
+struct LegacySylphideDecoder {
+  struct container_t : public std::deque<char> {
+    std::size_t stored() const {return size();}
+  } buffer;
+  std::istream &in;
+  LegacySylphideDecoder(std::istream &_in) : buffer(), in(_in) {}
+  bool pull(unsigned int n){
+    while(n--){
+      char c;
+      if(!in.get(c)){return false;}
+      buffer.push_back(c);
+    }
+    return true;
+  }
+  bool next(std::string &payload){
+    unsigned int buffer_size_min(SylphideProtocol::capsule_size);
+    bool header_checked(false);
+    while(true){
+      if(buffer.stored() < buffer_size_min){
+        if(!pull(buffer_size_min - buffer.stored())){return false;}
+      }
+      if(!header_checked){
+        if(!SylphideProtocol::Decorder::valid_head(buffer)){
+          buffer.pop_front();
+        }else{
+          header_checked = true;
+          buffer_size_min = SylphideProtocol::Decorder::packet_size(buffer);
+        }
+        continue;
+      }
+      if(SylphideProtocol::Decorder::validate(buffer)){
+        if(SylphideProtocol::Decorder::payload_size(buffer)
+            == payload_length){
+          break;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + buffer_size_min);
+      }else{
+        buffer.pop_front();
+      }
+      buffer_size_min = SylphideProtocol::capsule_size;
+      header_checked = false;
+    }
+    payload.assign(
+        buffer.begin() + SylphideProtocol::capsule_head_size,
+        buffer.begin() + SylphideProtocol::capsule_head_size + payload_length);
+    buffer.erase(buffer.begin(), buffer.begin() + buffer_size_min);
+    return true;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(decode){
+  std::srand(0);
+  std::vector<std::string> expected;
+  std::string stream(generate_sylphide_stream(0x1000, &expected));
+
+  std::vector<std::string> legacy;
+  {
+    std::istringstream in(stream);
+    LegacySylphideDecoder decoder(in);
+    std::string payload;
+    while(decoder.next(payload)){legacy.push_back(payload);}
+  }
+
+  std::vector<std::string> decoded;
+  {
+    std::istringstream in(stream);
+    SylphideIStream sylph_in(in, payload_length);
+    char buf[payload_length];
+    while(sylph_in.read(buf, sizeof(buf)).good()){
+      decoded.push_back(std::string(buf, sizeof(buf)));
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(decoded.size(), legacy.size());
+  for(std::size_t i(0); i < decoded.size(); ++i){
+    BOOST_REQUIRE(decoded[i] == legacy[i]);
+  }
+
+  // All intact packets should be decoded, in addition to rarely accepted fake ones.
+  std::size_t j(0);
+  for(std::size_t i(0); (i < decoded.size()) && (j < expected.size()); ++i){
+    if(decoded[i] == expected[j]){++j;}
+  }
+  BOOST_CHECK_EQUAL(j, expected.size());
+}
+
+BOOST_AUTO_TEST_CASE(decode_throughput){
+  std::srand(0);
+  std::string stream(generate_sylphide_stream(0x80000));
+  double mbps[2];
+  int packets[2] = {0};
+  {
+    std::istringstream in(stream);
+    LegacySylphideDecoder decoder(in);
+    std::string payload;
+    std::clock_t t0(std::clock());
+    while(decoder.next(payload)){++packets[0];}
+    mbps[0] = 1E-6 * stream.size() * CLOCKS_PER_SEC / (std::clock() - t0 + 1);
+  }
+  {
+    std::istringstream in(stream);
+    SylphideIStream sylph_in(in, payload_length);
+    char buf[payload_length];
+    std::clock_t t0(std::clock());
+    while(sylph_in.read(buf, sizeof(buf)).good()){++packets[1];}
+    mbps[1] = 1E-6 * stream.size() * CLOCKS_PER_SEC / (std::clock() - t0 + 1);
+  }
+  BOOST_CHECK_EQUAL(packets[0], packets[1]);
+  BOOST_TEST_MESSAGE("legacy decoder: " << mbps[0] << " [MB/s]");
+  BOOST_TEST_MESSAGE("contiguous decoder: " << mbps[1] << " [MB/s]");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
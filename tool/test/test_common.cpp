@@ -1,4 +1,15 @@
+#include <sstream>
+#include <string>
+#include <iomanip>
+#include <cmath>
+
 #include "analyze_common.h"
+#include "util/columnar.h"
+#include "util/num_format.h"
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
 
 #define BOOST_TEST_MAIN
 #include <boost/test/included/unit_test.hpp>
@@ -38,4 +49,70 @@ BOOST_AUTO_TEST_CASE(roll_over_monitor){
   BOOST_CHECK_EQUAL(true, monitor.abnormal_jump_detected);
 }
 
+BOOST_AUTO_TEST_CASE(columnar_writer){
+  ColumnarWriter writer('A');
+  writer.add("count", ColumnarWriter::UINT32)
+      .add("itow", ColumnarWriter::FLOAT64)
+      .add("index", ColumnarWriter::INT32);
+  std::stringstream ss;
+  writer.start(ss);
+  for(int i(0); i < 4; ++i){
+    writer << (i + 0x10203) << (0.5 * i) << -i;
+  }
+  std::string res(ss.str());
+
+  ColumnarWriter::header_t header;
+  std::memcpy(&header, res.data(), sizeof(header));
+  BOOST_REQUIRE_EQUAL(std::string(header.magic), "NSCOLMN");
+  BOOST_REQUIRE_EQUAL(header.columns, 3);
+  BOOST_REQUIRE_EQUAL(header.record_size, 16);
+  BOOST_REQUIRE_EQUAL(header.page, 'A');
+  ColumnarWriter::column_t columns[3];
+  std::memcpy(columns, res.data() + sizeof(header), sizeof(columns));
+  BOOST_REQUIRE_EQUAL(std::string(columns[1].name), "itow");
+  BOOST_REQUIRE_EQUAL(columns[1].type, 'd');
+  BOOST_REQUIRE_EQUAL(columns[2].offset, 12);
+
+  const std::size_t offset(sizeof(header) + sizeof(columns));
+  BOOST_REQUIRE_EQUAL(res.size(), offset + 16 * 4);
+  const unsigned char *record((const unsigned char *)res.data() + offset + 16 * 3);
+  BOOST_CHECK_EQUAL(record[0], 0x06); // little endian of 0x10206
+  BOOST_CHECK_EQUAL(record[1], 0x02);
+  BOOST_CHECK_EQUAL(record[2], 0x01);
+  double itow;
+  std::memcpy(&itow, record + 4, sizeof(itow));
+  BOOST_CHECK_EQUAL(itow, 1.5);
+  BOOST_CHECK_EQUAL(record[12], 0xFD); // -3
+  BOOST_CHECK_EQUAL(record[15], 0xFF);
+}
+
+BOOST_AUTO_TEST_CASE(fast_num_put){
+  std::ostringstream ss_fast, ss_std;
+  FastNumPut<>::imbue(ss_fast);
+  boost::random::mt19937 gen(0);
+  boost::random::uniform_real_distribution<> mantissa(-10, 10);
+  boost::random::uniform_int_distribution<> exponent(-30, 30), precision(1, 17);
+  for(int i(0); i < 100000; ++i){
+    double v(mantissa(gen) * std::pow(10., exponent(gen)));
+    switch(i % 8){
+      case 0: v = std::floor(v); break; // integral
+      case 1: v = std::floor(v * 8) / 8; break; // exactly representable fraction, may be tie
+    }
+    int prec(precision(gen));
+    ss_fast.str(""); ss_fast << std::setprecision(prec) << v;
+    ss_std.str(""); ss_std << std::setprecision(prec) << v;
+    BOOST_REQUIRE_EQUAL(ss_fast.str(), ss_std.str());
+  }
+
+  const double special[] = {0., -0., 1., -1., 0.5, 1E-5, 9.9999999999E-5, 1E15, 999999.5, 1E300};
+  for(unsigned int i(0); i < sizeof(special) / sizeof(special[0]); ++i){
+    ss_fast.str(""); ss_fast << std::setprecision(10) << special[i] << ',' << -123456789L << ',' << 0UL;
+    ss_std.str(""); ss_std << std::setprecision(10) << special[i] << ',' << -123456789L << ',' << 0UL;
+    BOOST_CHECK_EQUAL(ss_fast.str(), ss_std.str());
+  }
+  ss_fast.str(""); ss_fast << std::fixed << 1.25 << ',' << std::hex << 255L << ',' << std::setw(4) << 1.5;
+  ss_std.str(""); ss_std << std::fixed << 1.25 << ',' << std::hex << 255L << ',' << std::setw(4) << 1.5;
+  BOOST_CHECK_EQUAL(ss_fast.str(), ss_std.str());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
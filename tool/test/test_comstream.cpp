@@ -0,0 +1,151 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <ctime>
+
+#include "util/comstream.h"
+
+#if !defined(_WIN32)
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(comstream)
+
+#if !defined(_WIN32)
+
+/**
+ * Pseudo terminal pair, whose slave side is opened as a serial port.
+ */
+struct PTY_Fixture {
+  int master;
+  std::string slave_name;
+  std::vector<char> data;
+  PTY_Fixture() : master(posix_openpt(O_RDWR | O_NOCTTY)), slave_name(), data(0x40000) {
+    BOOST_REQUIRE(master != -1);
+    BOOST_REQUIRE(grantpt(master) == 0);
+    BOOST_REQUIRE(unlockpt(master) == 0);
+    slave_name = ptsname(master);
+    std::srand(0);
+    for(std::vector<char>::iterator it(data.begin()); it != data.end(); ++it){
+      *it = (char)(std::rand() & 0xFF);
+    }
+  }
+  ~PTY_Fixture(){
+    close(master);
+  }
+  void send(const std::size_t &size){
+    BOOST_REQUIRE(write(master, &data[0], size) == (ssize_t)size);
+    usleep(50000); // wait for arrival of all characters
+  }
+  /**
+   * Send data from master in chunks, while the slave side reads it with another thread.
+   */
+  template <class Reader>
+  std::vector<char> transfer(Reader &reader){
+    std::vector<char> received;
+    std::thread th([&](){reader(received);});
+    for(std::size_t i(0); i < data.size(); ){
+      std::size_t chunk(data.size() - i);
+      if(chunk > 0x1000){chunk = 0x1000;}
+      ssize_t written(write(master, &data[i], chunk));
+      if(written <= 0){break;}
+      i += written;
+    }
+    th.join();
+    return received;
+  }
+};
+
+struct StreamReader {
+  ComportStream &com;
+  std::size_t size;
+  bool bulk;
+  void operator()(std::vector<char> &buf){
+    buf.resize(size);
+    if(bulk){
+      com.read(&buf[0], size);
+      buf.resize(com.gcount());
+    }else{
+      for(std::size_t i(0); i < size; ++i){
+        int c(com.get());
+        if(c == EOF){buf.resize(i); break;}
+        buf[i] = (char)c;
+      }
+    }
+  }
+};
+
+static void check_transfer(PTY_Fixture &pty, ComportStream &com, const bool &bulk){
+  StreamReader reader = {com, pty.data.size(), bulk};
+  std::clock_t t0(std::clock());
+  std::vector<char> received(pty.transfer(reader));
+  std::clock_t t1(std::clock());
+  BOOST_REQUIRE_EQUAL(received.size(), pty.data.size());
+  for(std::size_t i(0); i < received.size(); ++i){
+    BOOST_REQUIRE_EQUAL(received[i], pty.data[i]);
+  }
+  BOOST_TEST_MESSAGE((bulk ? "read(): " : "get(): ")
+      << (double)(t1 - t0) * 1E3 / CLOCKS_PER_SEC << " [ms] (CPU time)");
+}
+
+BOOST_FIXTURE_TEST_CASE(unbuffered, PTY_Fixture){
+  ComportStream com(slave_name.c_str());
+  com.buffer().set_buffer_size(1);
+  BOOST_TEST_MESSAGE("unbuffered");
+  check_transfer(*this, com, false);
+}
+
+BOOST_FIXTURE_TEST_CASE(buffered, PTY_Fixture){
+  ComportStream com(slave_name.c_str());
+  BOOST_TEST_MESSAGE("buffered");
+  check_transfer(*this, com, false);
+  check_transfer(*this, com, true);
+}
+
+BOOST_FIXTURE_TEST_CASE(read_timing, PTY_Fixture){
+  ComportStream com(slave_name.c_str());
+  com.buffer().set_read_timing(0, 1); // return after 0.1 sec without data
+  BOOST_TEST_MESSAGE("VMIN=0, VTIME=1");
+  check_transfer(*this, com, true);
+  BOOST_CHECK_EQUAL(com.buffer().sgetc(), EOF);
+}
+
+BOOST_FIXTURE_TEST_CASE(background_reader, PTY_Fixture){
+  ComportStream com(slave_name.c_str());
+  send(0x10);
+  BOOST_REQUIRE_EQUAL(com.get(), (int)(unsigned char)data[0]); // characters buffered in advance
+  com.buffer().start_reader(0x100, 4);
+  BOOST_REQUIRE(com.buffer().is_reader_running());
+  for(int i(1); i < 0x10; ++i){
+    BOOST_REQUIRE_EQUAL(com.get(), (int)(unsigned char)data[i]);
+  }
+  BOOST_TEST_MESSAGE("background reader");
+  check_transfer(*this, com, false);
+  check_transfer(*this, com, true);
+
+  send(0x10);
+  BOOST_REQUIRE_EQUAL(com.get(), (int)(unsigned char)data[0]);
+  com.buffer().stop_reader();
+  BOOST_REQUIRE(!com.buffer().is_reader_running());
+  for(int i(1); i < 0x10; ++i){ // characters in the current page are kept
+    BOOST_REQUIRE_EQUAL(com.get(), (int)(unsigned char)data[i]);
+  }
+}
+
+#else
+
+BOOST_AUTO_TEST_CASE(pty_unavailable){
+  BOOST_TEST_MESSAGE("Tests using pseudo terminal are skipped.");
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
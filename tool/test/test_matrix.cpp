@@ -6,6 +6,11 @@
 #include <set>
 #include <deque>
 #include <algorithm>
+#include <ctime>
+#if defined(MATRIX_ATOMIC_REFCOUNT)
+#include <thread>
+#include <functional>
+#endif
 
 #include <boost/type_traits/is_same.hpp>
 
@@ -792,6 +797,35 @@ BOOST_AUTO_TEST_CASE(LU){
   check_LU(*A);
 }
 
+void check_solve(const matrix_t &mat, const matrix_t &y){
+  matrix_t x(mat.solve(y));
+  BOOST_TEST_MESSAGE("solve(x):" << x);
+  matrix_compare_delta(y, matrix_t(mat * x), ACCEPTABLE_DELTA_DEFAULT);
+  matrix_compare_delta(matrix_t(mat.inverse() * y), x, ACCEPTABLE_DELTA_DEFAULT);
+
+  matrix_t spd(matrix_t(mat * mat.transpose()) + matrix_t::getI(mat.rows()));
+  matrix_t x2(spd.solve_spd(y));
+  BOOST_TEST_MESSAGE("solve_spd(x):" << x2);
+  matrix_compare_delta(y, matrix_t(spd * x2), ACCEPTABLE_DELTA_DEFAULT);
+  matrix_compare_delta(spd.solve(y), x2, ACCEPTABLE_DELTA_DEFAULT);
+  matrix_t x3(spd.solve_spd(y.partial(y.rows(), 1).transpose().transpose()));
+  matrix_compare_delta(x2.partial(x2.rows(), 1), x3, ACCEPTABLE_DELTA_DEFAULT);
+
+  BOOST_CHECK_THROW(
+      matrix_t(mat.rows(), mat.columns()).solve(y), std::runtime_error); // singular
+  BOOST_CHECK_THROW(
+      matrix_t(spd * -1).solve_spd(y), std::runtime_error); // not positive definite
+  BOOST_CHECK_THROW(mat.solve(y.partial(y.rows() - 1, y.columns())), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(solve){
+  prologue_print();
+  check_solve(*A, *B);
+  assign_intermediate_zeros();
+  prologue_print();
+  check_solve(*A, *B);
+}
+
 BOOST_AUTO_TEST_CASE(UH){
   prologue_print();
   matrix_t U(matrix_t::getI(A->rows()));
@@ -961,4 +995,358 @@ BOOST_AUTO_TEST_CASE(unrolled_product){ // This test is experimental for SIMD su
   delete [] AB_array;
 }
 
+template <class MatrixT1, class MatrixT2>
+matrix_t mat_mul_elementwise(const MatrixT1 &m1, const MatrixT2 &m2){
+  // expression template version evaluating each element on demand
+  matrix_t res(m1.rows(), m2.columns());
+  for(unsigned int i(0); i < res.rows(); ++i){
+    for(unsigned int j(0); j < res.columns(); ++j){
+      res(i, j) = (m1 * m2)(i, j);
+    }
+  }
+  return res;
+}
+
+BOOST_AUTO_TEST_CASE(dense_product){
+  static const unsigned int sizes[] = {1, 3, 7, 16, 33, 64, 300};
+  static const unsigned int num(sizeof(sizes) / sizeof(sizes[0]));
+  for(unsigned int i(0); i < num; ++i){
+    for(unsigned int j(0); j < num; ++j){
+      matrix_t m1(sizes[i], sizes[j]), m2(sizes[j], sizes[i]);
+      for(unsigned int k(0); k < m1.rows(); ++k){
+        for(unsigned int l(0); l < m1.columns(); ++l){
+          m1(k, l) = gen_rand();
+          m2(l, k) = gen_rand();
+        }
+      }
+      matrix_t m1_t(m1.transpose().copy()), m2_t(m2.transpose().copy());
+
+      // kernel for dense matrices must be identical to the expression template version
+      matrix_compare(mat_mul_elementwise(m1, m2), matrix_t(m1 * m2));
+      matrix_compare(mat_mul_elementwise(m1, m2), matrix_t(m2_t * m1_t).transpose());
+      matrix_compare(mat_mul_elementwise(m1, m2), matrix_t(m1 * m2_t.transpose()));
+      matrix_compare(mat_mul_elementwise(m1, m2), matrix_t(m1_t.transpose() * m2));
+      matrix_compare(mat_mul_elementwise(m1, m2), matrix_t(m1_t.transpose() * m2_t.transpose()));
+      matrix_compare(mat_mul_elementwise(m1_t.transpose(), m1_t), matrix_t(m1_t.transpose() * m1_t));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(dense_pool){
+  const content_t *released;
+  {
+    matrix_t m(4, 5);
+    released = &m(0, 0);
+  }
+  {
+    // a block of the same size class is reused
+    matrix_t m(5, 4);
+    BOOST_CHECK_EQUAL(released, &m(0, 0));
+    matrix_t m2(m); // shallow copy shares the block
+    BOOST_CHECK_EQUAL(&m(0, 0), &m2(0, 0));
+  }
+  {
+    matrix_t m(SIZE, SIZE);
+    for(unsigned int i(0); i < m.rows(); ++i){
+      for(unsigned int j(0); j < m.columns(); ++j){
+        BOOST_REQUIRE_EQUAL(m(i, j), 0);
+      }
+    }
+    cmatrix_t cm(SIZE, SIZE);
+    for(unsigned int i(0); i < cm.rows(); ++i){
+      for(unsigned int j(0); j < cm.columns(); ++j){
+        BOOST_REQUIRE_EQUAL(cm(i, j).real(), 0);
+        BOOST_REQUIRE_EQUAL(cm(i, j).imaginary(), 0);
+      }
+    }
+  }
+  {
+    // a large block is not pooled, but is correctly handled
+    matrix_t m(200, 200);
+    m(199, 199) = 1;
+    BOOST_CHECK_EQUAL(m.copy()(199, 199), 1);
+  }
+}
+
+#if defined(MATRIX_COPY_ON_WRITE)
+BOOST_AUTO_TEST_CASE(copy_on_write){
+  matrix_t m(3, 3);
+  for(unsigned int i(0); i < m.rows(); ++i){
+    for(unsigned int j(0); j < m.columns(); ++j){
+      m(i, j) = i * m.columns() + j + 1;
+    }
+  }
+  {
+    // by default, modification is shared with shallow copies
+    matrix_t m_copy(m.copy()), m_shallow(m_copy);
+    m_shallow(0, 0) = -1;
+    BOOST_CHECK_EQUAL(m_copy(0, 0), -1);
+  }
+  const matrix_t m_orig(m.copy());
+  m.copy_on_write();
+  {
+    matrix_t m_shallow(m);
+    m_shallow(0, 0) = -1; // detached
+    BOOST_CHECK_EQUAL(m(0, 0), 1);
+    BOOST_CHECK_EQUAL(m_shallow(0, 0), -1);
+    BOOST_CHECK_EQUAL(m_shallow(2, 2), m(2, 2)); // elements are copied
+    m_shallow(1, 1) = -2; // no longer shared
+    BOOST_CHECK_EQUAL(m_shallow(1, 1), -2);
+    BOOST_CHECK_EQUAL(m(1, 1), m_orig(1, 1));
+
+    matrix_t::partial_t m_partial(m.partial(2, 2, 1, 1));
+    m_partial(0, 0) = -3; // view is also detached
+    BOOST_CHECK_EQUAL(m_partial(0, 0), -3);
+    BOOST_CHECK_EQUAL(m_partial(1, 1), m(2, 2));
+    BOOST_CHECK_EQUAL(m(1, 1), m_orig(1, 1));
+
+    matrix_t m_cleared(m);
+    m_cleared.clear();
+    BOOST_CHECK_EQUAL(m_cleared(2, 2), 0);
+    BOOST_CHECK_EQUAL(m(2, 2), m_orig(2, 2));
+  }
+  {
+    // the only holder modifies the storage in place
+    content_t *p(&m(0, 0));
+    m(0, 0) = 10;
+    BOOST_CHECK_EQUAL(p, &m(0, 0));
+    m(0, 0) = m_orig(0, 0);
+  }
+  {
+    // unmarked storage is shared again
+    matrix_t m_shallow(m);
+    m_shallow.copy_on_write(false);
+    m_shallow(2, 0) = -4;
+    BOOST_CHECK_EQUAL(m(2, 0), -4);
+    m(2, 0) = m_orig(2, 0);
+  }
+  {
+    // detached holders keep copy-on-write
+    matrix_t m_shallow(m);
+    m_shallow(0, 0) = -5; // detached
+    matrix_t m_shallow2(m_shallow);
+    m_shallow2(0, 0) = -6; // detached again
+    BOOST_CHECK_EQUAL(m_shallow(0, 0), -5);
+    BOOST_CHECK_EQUAL(m_shallow2(0, 0), -6);
+
+    matrix_t m_shallow3(m);
+    m(0, 0) = -7; // the original holder is detached
+    matrix_t m_shallow4(m);
+    m_shallow4(0, 0) = -8;
+    BOOST_CHECK_EQUAL(m(0, 0), -7);
+    BOOST_CHECK_EQUAL(m_shallow3(0, 0), m_orig(0, 0));
+    BOOST_CHECK_EQUAL(m_shallow4(0, 0), -8);
+  }
+}
+#endif
+
+#if defined(MATRIX_ATOMIC_REFCOUNT) && defined(MATRIX_COPY_ON_WRITE)
+BOOST_AUTO_TEST_CASE(shared_among_threads){
+  matrix_t m(SIZE, SIZE);
+  for(unsigned int i(0); i < m.rows(); ++i){
+    for(unsigned int j(0); j < m.columns(); ++j){
+      m(i, j) = gen_rand();
+    }
+  }
+  const matrix_t m_orig(m.copy());
+  m.copy_on_write();
+  struct worker_t {
+    const matrix_t &src;
+    content_t sum;
+    worker_t(const matrix_t &m) : src(m), sum(0) {}
+    void operator()(){
+      for(int k(0); k < 10000; ++k){
+        const matrix_t m_shallow(src);
+        sum += m_shallow(k % SIZE, 0); // const access does not detach, thus read in parallel
+        if(k % 100 == 0){
+          matrix_t m_write(m_shallow);
+          m_write(0, 0) += 1; // detached
+        }
+      }
+    }
+  };
+  std::deque<worker_t> workers;
+  std::deque<std::thread> threads;
+  for(int i(0); i < 4; ++i){
+    workers.push_back(worker_t(m));
+    threads.push_back(std::thread(std::ref(workers.back())));
+  }
+  for(int i(0); i < 4; ++i){threads[i].join();}
+  for(int i(1); i < 4; ++i){BOOST_CHECK_EQUAL(workers[0].sum, workers[i].sum);}
+  for(unsigned int i(0); i < m.rows(); ++i){
+    for(unsigned int j(0); j < m.columns(); ++j){
+      BOOST_REQUIRE_EQUAL(m(i, j), m_orig(i, j));
+    }
+  }
+  content_t *p(&m(0, 0)); // every copy has been released, thus no detach
+  BOOST_CHECK_EQUAL(p, &m(0, 0));
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(shared_storage_speed){
+  matrix_t m(SIZE, SIZE);
+  static const int loops(1 << 20);
+  double t[2];
+  {
+    std::clock_t t0(std::clock());
+    for(int i(0); i < loops; ++i){
+      matrix_t m_shallow(m);
+    }
+    t[0] = 1E9 * (std::clock() - t0) / CLOCKS_PER_SEC / loops;
+  }
+  {
+    std::clock_t t0(std::clock());
+    for(int i(0); i < loops; ++i){
+      m(i % SIZE, (i / SIZE) % SIZE) += 1;
+    }
+    t[1] = 1E9 * (std::clock() - t0) / CLOCKS_PER_SEC / loops;
+  }
+  BOOST_TEST_MESSAGE("shallow copy: " << t[0] << " [ns], element write: " << t[1] << " [ns]"
+#if defined(MATRIX_ATOMIC_REFCOUNT)
+      << " (atomic reference counter)"
+#endif
+#if defined(MATRIX_COPY_ON_WRITE)
+      << " (copy-on-write)"
+#endif
+      );
+}
+
+BOOST_AUTO_TEST_CASE(dense_product_speed){
+  static const unsigned int sizes[] = {3, 6, 9, 16, 32, 64};
+  for(unsigned int k(0); k < sizeof(sizes) / sizeof(sizes[0]); ++k){
+    const unsigned int n(sizes[k]);
+    matrix_t m1(n, n), m2(n, n);
+    for(unsigned int i(0); i < n; ++i){
+      for(unsigned int j(0); j < n; ++j){
+        m1(i, j) = gen_rand();
+        m2(i, j) = gen_rand();
+      }
+    }
+    const unsigned int loops((1 << 16) / (n * n) + 1);
+    double t[2];
+    {
+      std::clock_t t0(std::clock());
+      for(unsigned int i(0); i < loops; ++i){
+        mat_mul_elementwise(m1, m2);
+      }
+      t[0] = (double)(std::clock() - t0) / CLOCKS_PER_SEC / loops;
+    }
+    {
+      std::clock_t t0(std::clock());
+      for(unsigned int i(0); i < loops; ++i){
+        matrix_t(m1 * m2);
+      }
+      t[1] = (double)(std::clock() - t0) / CLOCKS_PER_SEC / loops;
+    }
+    BOOST_TEST_MESSAGE("dense product(" << n << "x" << n << "): "
+        << t[0] * 1E6 << " => " << t[1] * 1E6 << " [us]");
+  }
+}
+
+matrix_t mat_mul_nested_uncached(const matrix_t &m1, const matrix_t &m2){
+  // m1 * m2 * m1^{T} whose inner product is reevaluated for each element, i.e., O(n^4)
+  matrix_t res(m1.rows(), m1.rows());
+  for(unsigned int i(0); i < res.rows(); ++i){
+    for(unsigned int j(0); j < res.columns(); ++j){
+      content_t sum(0);
+      for(unsigned int p(0); p < m2.rows(); ++p){
+        for(unsigned int q(0); q < m2.columns(); ++q){
+          sum += m1(i, p) * m2(p, q) * m1(j, q);
+        }
+      }
+      res(i, j) = sum;
+    }
+  }
+  return res;
+}
+
+/**
+ * Scalar counting its multiplications, which reveals how many times operands are evaluated.
+ */
+struct counted_t {
+  content_t v;
+  static unsigned int multiplications;
+  counted_t(const content_t &_v = 0) : v(_v) {}
+  counted_t operator*(const counted_t &another) const {
+    ++multiplications;
+    return counted_t(v * another.v);
+  }
+  counted_t operator+(const counted_t &another) const {return counted_t(v + another.v);}
+  counted_t &operator+=(const counted_t &another){v += another.v; return *this;}
+};
+unsigned int counted_t::multiplications = 0;
+
+BOOST_AUTO_TEST_CASE(nested_product){
+  // filter shapes, i.e., (state, observation) = (10, 6) for INS/GPS, (16, 6) for INS/GPS with bias
+  static const unsigned int sizes[][2] = {{10, 6}, {16, 6}};
+  for(unsigned int k(0); k < sizeof(sizes) / sizeof(sizes[0]); ++k){
+    const unsigned int n(sizes[k][0]), m(sizes[k][1]);
+    matrix_t Phi(n, n), P(n, n), H(m, n), R(matrix_t::getI(m));
+    for(unsigned int i(0); i < n; ++i){
+      for(unsigned int j(0); j < n; ++j){
+        Phi(i, j) = gen_rand();
+        P(i, j) = gen_rand();
+      }
+      for(unsigned int j(0); j < m; ++j){
+        H(j, i) = gen_rand();
+      }
+    }
+    P = matrix_t(P * P.transpose());
+
+    // inner products are evaluated once as caches, then results must be identical to two-step ones
+    matrix_t PhiP(Phi * P);
+    matrix_compare(matrix_t(PhiP * Phi.transpose()), matrix_t(Phi * P * Phi.transpose()));
+    matrix_t PHt(P * H.transpose()), HPHt_R(matrix_t(matrix_t(H * P) * H.transpose()) + R);
+    matrix_compare(HPHt_R, matrix_t((H * P * H.transpose()) + R));
+    matrix_t K(PHt * HPHt_R.inverse());
+    matrix_compare(K, matrix_t(P * H.transpose() * ((H * P * H.transpose()) + R).inverse()));
+    matrix_t KH(K * H), I_KH(matrix_t::getI(n) - KH);
+    matrix_compare(I_KH, matrix_t(matrix_t::getI(n) - K * H));
+    matrix_compare(matrix_t(I_KH * P), matrix_t((matrix_t::getI(n) - K * H) * P));
+
+    matrix_compare_delta(
+        mat_mul_nested_uncached(Phi, P), matrix_t(Phi * P * Phi.transpose()),
+        ACCEPTABLE_DELTA_DEFAULT);
+
+    {
+      // each product must be evaluated once, i.e., O(n^3) multiplications instead of O(n^4)
+      Matrix<counted_t> Phi_c(n, n), P_c(n, n), H_c(m, n);
+      counted_t::multiplications = 0;
+      Matrix<counted_t>(Phi_c * P_c * Phi_c.transpose());
+      BOOST_CHECK_EQUAL(counted_t::multiplications, n * n * n * 2);
+      counted_t::multiplications = 0;
+      Matrix<counted_t>(H_c * P_c * H_c.transpose());
+      BOOST_CHECK_EQUAL(counted_t::multiplications, (m * n * n) + (m * n * m));
+    }
+
+    const unsigned int loops((1 << 18) / (n * n * n) + 1);
+    double t[3];
+    {
+      std::clock_t t0(std::clock());
+      for(unsigned int i(0); i < loops; ++i){
+        mat_mul_nested_uncached(Phi, P);
+      }
+      t[0] = (double)(std::clock() - t0) / CLOCKS_PER_SEC / loops;
+    }
+    {
+      std::clock_t t0(std::clock());
+      for(unsigned int i(0); i < loops; ++i){
+        matrix_t(matrix_t(Phi * P) * Phi.transpose());
+      }
+      t[1] = (double)(std::clock() - t0) / CLOCKS_PER_SEC / loops;
+    }
+    {
+      std::clock_t t0(std::clock());
+      for(unsigned int i(0); i < loops; ++i){
+        matrix_t(Phi * P * Phi.transpose());
+      }
+      t[2] = (double)(std::clock() - t0) / CLOCKS_PER_SEC / loops;
+    }
+    BOOST_TEST_MESSAGE("nested product Phi * P * Phi^{T} (" << n << "x" << n << "): "
+        << t[0] * 1E6 << " (uncached) => "
+        << t[1] * 1E6 << " (two-step) => "
+        << t[2] * 1E6 << " (nested) [us]");
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2017, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __COLUMNAR_H__
+#define __COLUMNAR_H__
+
+#include <ostream>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Writer of fixed width binary records, which is an alternative to text CSV.
+ * A file starts with a header and column descriptors, followed by records,
+ * each of which has the same layout given by the descriptors.
+ * All values are little endian, then a reader can map the file to memory and
+ * access a column with a constant stride (for example, numpy.memmap with a structured dtype).
+ *
+ * Values are appended with operator<< in the column order, and a record is written
+ * when all of its columns are filled.
+ */
+class ColumnarWriter {
+  public:
+    enum type_t {
+      INT32 = 'i',
+      UINT32 = 'u',
+      FLOAT64 = 'd',
+    };
+
+    struct header_t {
+      char magic[8]; ///< "NSCOLMN"
+      int version;
+      int columns; ///< number of column descriptors following the header
+      int record_size; ///< [bytes]
+      char page; ///< page type, such as 'A'
+      char reserved[3];
+      static const int current_version = 1;
+    };
+
+    struct column_t {
+      char name[24]; ///< null terminated
+      char type; ///< one of type_t
+      char reserved[3];
+      int offset; ///< offset in a record [bytes]
+    };
+
+  protected:
+    std::ostream *out;
+    header_t header;
+    std::vector<column_t> columns;
+    std::vector<char> record;
+    unsigned int index; ///< column to be filled next
+
+    static bool is_little_endian(){
+      static const unsigned int one(1);
+      return *reinterpret_cast<const char *>(&one) == 1;
+    }
+
+    /**
+     * Store a value in little endian
+     */
+    template <class T>
+    static void store(char *dst, const T &v){
+      std::memcpy(dst, &v, sizeof(T));
+      if(!is_little_endian()){
+        for(unsigned int i(0), j(sizeof(T) - 1); i < j; ++i, --j){
+          char c(dst[i]); dst[i] = dst[j]; dst[j] = c;
+        }
+      }
+    }
+
+    template <class T>
+    void put(const T &v){
+      store(&record[columns[index].offset], v);
+    }
+
+  public:
+    ColumnarWriter(const char &page = 0) : out(NULL), columns(), record(), index(0) {
+      std::memset(&header, 0, sizeof(header));
+      std::memcpy(header.magic, "NSCOLMN", sizeof(header.magic));
+      header.version = header_t::current_version;
+      header.page = page;
+    }
+
+    /**
+     * Append a column, which is available before start().
+     */
+    ColumnarWriter &add(const char *name, const type_t &type){
+      column_t column;
+      std::memset(&column, 0, sizeof(column));
+      std::strncpy(column.name, name, sizeof(column.name) - 1);
+      column.type = (char)type;
+      column.offset = header.record_size;
+      header.record_size += ((type == FLOAT64) ? 8 : 4);
+      columns.push_back(column);
+      header.columns = (int)columns.size();
+      return *this;
+    }
+    template <std::size_t N>
+    ColumnarWriter &add(const char *(&names)[N], const type_t &type){
+      for(std::size_t i(0); i < N; ++i){add(names[i], type);}
+      return *this;
+    }
+
+    /**
+     * Start output by writing the header and the column descriptors.
+     */
+    void start(std::ostream &_out){
+      out = &_out;
+      record.assign(header.record_size, 0);
+      index = 0;
+      header_t header_le(header);
+      store(reinterpret_cast<char *>(&header_le.version), header.version);
+      store(reinterpret_cast<char *>(&header_le.columns), header.columns);
+      store(reinterpret_cast<char *>(&header_le.record_size), header.record_size);
+      out->write(reinterpret_cast<const char *>(&header_le), sizeof(header_le));
+      for(std::vector<column_t>::const_iterator it(columns.begin()); it != columns.end(); ++it){
+        column_t column_le(*it);
+        store(reinterpret_cast<char *>(&column_le.offset), it->offset);
+        out->write(reinterpret_cast<const char *>(&column_le), sizeof(column_le));
+      }
+    }
+
+    bool is_started() const {
+      return out != NULL;
+    }
+
+    const char &page() const {
+      return header.page;
+    }
+
+    /**
+     * Fill the next column, whose type determines the conversion of the value.
+     */
+    ColumnarWriter &operator<<(const double &v){
+      switch(columns[index].type){
+        case INT32: put((int)v); break;
+        case UINT32: put((unsigned int)v); break;
+        default: put(v); break;
+      }
+      if(++index >= columns.size()){
+        out->write(&record[0], record.size());
+        index = 0;
+      }
+      return *this;
+    }
+};
+
+#endif /* __COLUMNAR_H__ */
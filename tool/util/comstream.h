@@ -35,8 +35,18 @@
 #include <streambuf>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <cstring>
+#include <cstddef>
+
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1700))
+#define COMSTREAM_USE_THREAD 1
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#endif
 
 #ifdef _WIN32
 #include <windows.h>
@@ -45,13 +55,19 @@
 #include <termios.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <cstdio>
+#include <cerrno>
 #endif
 
 /**
  * Blocking streambuf for serial/tty port
  * 
+ * Input is buffered; one read request fetches all available characters
+ * up to the buffer size (see set_buffer_size()) instead of a single character.
+ * Optionally, a background thread reads the port, and hands filled pages to the consumer
+ * through a single-producer single-consumer ring (see start_reader()).
  */
 template<
     class _Elem, 
@@ -68,8 +84,104 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
     typedef std::streamsize streamsize;
     typedef typename super_t::int_type int_type;
     handle_t handle;
-    int_type in_buf;
-    bool in_buf_ready;
+    std::vector<_Elem> in_buf;
+#if defined(COMSTREAM_USE_THREAD)
+    /**
+     * Background reader, which is the producer of a ring of pages.
+     * The consumer is underflow() of the owner streambuf.
+     */
+    struct reader_t {
+      struct page_t {
+        std::vector<_Elem> data;
+        streamsize length; ///< number of valid characters; zero means the end of stream
+      };
+      std::vector<page_t> pages;
+      std::atomic<std::size_t> head; ///< count of filled pages, updated only by the producer
+      std::atomic<std::size_t> tail; ///< count of released pages, updated only by the consumer
+      std::atomic<bool> stop;
+      bool holding; ///< true when the consumer is reading pages[tail % pages.size()]
+      std::mutex mutex; ///< only for waiting; head, tail and stop are updated without lock
+      std::condition_variable cond; ///< notified when head, tail or stop is updated
+      std::atomic<int> waiters; ///< number of threads waiting for cond
+      std::thread worker;
+
+      /**
+       * Wake up the other side after head, tail or stop has been updated.
+       * The update and the check of waiters are sequentially consistent,
+       * therefore, either the notifier finds the waiter, or the waiter finds the update.
+       */
+      void notify(){
+        if(waiters.load() == 0){return;}
+        {std::lock_guard<std::mutex> lock(mutex);} // the waiter is in cond.wait() or before the check
+        cond.notify_all();
+      }
+      /**
+       * Block until the condition is satisfied.
+       */
+      template <class Condition>
+      void wait(Condition cond_satisfied){
+        std::unique_lock<std::mutex> lock(mutex);
+        ++waiters;
+        while(!cond_satisfied()){cond.wait(lock);}
+        --waiters;
+      }
+      bool is_full(const std::size_t &h) const {
+        return (h - tail.load()) >= pages.size();
+      }
+      void run(basic_ComportStreambuf *buf){
+        std::size_t h(head.load(std::memory_order_relaxed));
+        while(!stop.load()){
+          if(is_full(h)){
+            wait([&]{return stop.load() || !is_full(h);});
+            continue;
+          }
+          int state(buf->wait_readable(100)); // blocks in poll() until readable
+          if(state == 0){continue;} // timeout, then check stop request
+          page_t &page(pages[h % pages.size()]);
+          page.length = (state > 0)
+              ? buf->read_some(&page.data[0], (streamsize)page.data.size())
+              : 0;
+          head.store(++h);
+          notify();
+          if(page.length == 0){break;}
+        }
+      }
+      reader_t(basic_ComportStreambuf *buf,
+          const std::size_t &page_size, const std::size_t &num_pages)
+          : pages(num_pages), head(0), tail(0), stop(false), holding(false),
+          mutex(), cond(), waiters(0), worker() {
+        for(typename std::vector<page_t>::iterator it(pages.begin()); it != pages.end(); ++it){
+          it->data.resize(page_size);
+          it->length = 0;
+        }
+        worker = std::thread(&reader_t::run, this, buf);
+      }
+      ~reader_t(){
+        stop.store(true);
+        notify();
+        worker.join();
+      }
+      /**
+       * Release the current page, and wait for the next one.
+       */
+      const page_t &next(){
+        std::size_t t(tail.load(std::memory_order_relaxed));
+        if(holding){
+          if(pages[t % pages.size()].length == 0){ // end of stream is kept
+            return pages[t % pages.size()];
+          }
+          tail.store(++t);
+          holding = false;
+          notify();
+        }
+        if(head.load(std::memory_order_acquire) == t){
+          wait([&]{return head.load() != t;});
+        }
+        holding = true;
+        return pages[t % pages.size()];
+      }
+    } *reader;
+#endif
     static handle_t spec2handle(const char *port_spec){
       std::string regular_name(port_spec);
 #ifdef _WIN32
@@ -195,6 +307,42 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
       SetCommBreak(handle);
       ClearCommBreak(handle);
     }
+    /**
+     * Emulate VMIN and VTIME of POSIX termios with COMMTIMEOUTS.
+     * Only the inter-character timer is effective.
+     *
+     * @param vmin ignored
+     * @param vtime inter-character timer [0.1 sec]
+     */
+    void set_read_timing(const int &vmin, const int &vtime){
+      COMMTIMEOUTS tout;
+      GetCommTimeouts(handle, &tout);
+      tout.ReadIntervalTimeout = (DWORD)vtime * 100;
+      SetCommTimeouts(handle, &tout);
+    }
+    int wait_readable(const int &timeout_ms){
+      for(int elapsed(0); (timeout_ms < 0) || (elapsed <= timeout_ms); ++elapsed){
+        DWORD dwerrors;
+        COMSTAT comstat;
+        if(!ClearCommError(handle, &dwerrors, &comstat)){return -1;}
+        if(comstat.cbInQue > 0){return 1;}
+        Sleep(1);
+      }
+      return 0;
+    }
+    streamsize read_some(_Elem *s, const streamsize &n){
+      DWORD dwerrors, received;
+      COMSTAT comstat;
+      DWORD request(1); // wait at least one character
+      if(ClearCommError(handle, &dwerrors, &comstat) && (comstat.cbInQue > sizeof(_Elem))){
+        request = comstat.cbInQue / sizeof(_Elem);
+      }
+      if(request > (DWORD)n){request = (DWORD)n;}
+      if(ReadFile(handle, (LPVOID)s, sizeof(_Elem) * request, &received, NULL)){
+        return (streamsize)(received / sizeof(_Elem));
+      }
+      return 0;
+    }
 #else
     static int speed_to_num(const speed_t &speed){
       static const struct {
@@ -398,16 +546,72 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
     void clear_error(){
       tcflush(handle, TCIFLUSH);
     }
+    /**
+     * Configure VMIN and VTIME, which control latency of read.
+     * A read returns when vmin characters arrive or the interval between characters
+     * exceeds vtime; larger values reduce system calls in exchange for latency.
+     *
+     * @param vmin minimum number of characters (0-255)
+     * @param vtime inter-character timer [0.1 sec] (0-255)
+     */
+    void set_read_timing(const int &vmin, const int &vtime){
+      struct termios config_data;
+      if(tcgetattr(handle, &config_data) == -1){return;}
+      config_data.c_cc[VMIN] = (cc_t)vmin;
+      config_data.c_cc[VTIME] = (cc_t)vtime;
+      tcsetattr(handle, TCSANOW, &config_data);
+    }
+    /**
+     * Wait until characters become readable
+     *
+     * @param timeout_ms timeout [ms]; negative value means infinite.
+     * @return (int) 1 when readable, 0 when timeout, and -1 when error or hang up.
+     */
+    int wait_readable(const int &timeout_ms){
+      struct pollfd pfd;
+      pfd.fd = handle;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      int res;
+      while(((res = poll(&pfd, 1, timeout_ms)) == -1) && (errno == EINTR));
+      if(res <= 0){return res;}
+      return (pfd.revents & POLLIN) ? 1 : -1;
+    }
+    /**
+     * Read available characters at once.
+     * At least one character is waited.
+     *
+     * @return (streamsize) number of read characters; zero means error or the end of stream.
+     */
+    streamsize read_some(_Elem *s, const streamsize &n){
+      ssize_t res;
+      while(((res = read(handle, (void *)s, sizeof(_Elem) * n)) == -1) && (errno == EINTR));
+      return (res > 0) ? (streamsize)(res / sizeof(_Elem)) : 0;
+    }
 #endif
     handle_t get_handle() const {
       return handle;
     }
-    basic_ComportStreambuf(const char *port_spec)
-        : super_t(), handle(spec2handle(port_spec)), in_buf_ready(false) {
+    /**
+     * Constructor
+     *
+     * @param port_spec port name
+     * @param buffer_size size of input buffer; 1 means character-by-character reading.
+     */
+    basic_ComportStreambuf(const char *port_spec, const std::size_t &buffer_size = 0x1000)
+        : super_t(), handle(spec2handle(port_spec)), in_buf(buffer_size > 0 ? buffer_size : 1)
+#if defined(COMSTREAM_USE_THREAD)
+        , reader(NULL)
+#endif
+        {
       config();
       clear_error();
+      super_t::setg(&in_buf[0], &in_buf[0], &in_buf[0]);
     }
     virtual ~basic_ComportStreambuf() {
+#if defined(COMSTREAM_USE_THREAD)
+      delete reader;
+#endif
 #ifdef _WIN32
       CloseHandle(handle);
 #else
@@ -415,26 +619,59 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
 #endif
       //std::cerr << "~()" << std::endl;
     }
-    void update_in_buf(){
-      in_buf_ready = true;
-#ifdef _WIN32
-      DWORD received;
-      //static int seq_num(0);
-      //seq_num++;
-      //std::cerr << "update_in_buf() : " << seq_num << std::endl;
-      if(ReadFile(handle, (LPVOID)&in_buf, 1, &received, NULL)
-          && (received > 0)){
-        //std::cerr << "received!" << std::endl;
-        return;
-      }
-      //std::cerr << "return update_in_buf() : " << seq_num << std::endl;
-#else
-      if(read(handle, (void *)&in_buf, 1)){
-        return;
-      }
-#endif
-      in_buf = _Traits::eof();
+
+  protected:
+    /**
+     * Move unread characters in the get area to the head of the input buffer.
+     */
+    void keep_unread(std::size_t buffer_size){
+      streamsize unread(super_t::egptr() - super_t::gptr());
+      if(buffer_size < (std::size_t)unread){buffer_size = (std::size_t)unread;}
+      if(buffer_size < 1){buffer_size = 1;}
+      std::vector<_Elem> buf(buffer_size);
+      if(unread > 0){_Traits::copy(&buf[0], super_t::gptr(), (std::size_t)unread);}
+      in_buf.swap(buf);
+      super_t::setg(&in_buf[0], &in_buf[0], &in_buf[0] + unread);
     }
+
+  public:
+    /**
+     * Change the size of input buffer. Unread characters are preserved.
+     *
+     * @param buffer_size new size; 1 means character-by-character reading.
+     */
+    void set_buffer_size(const std::size_t &buffer_size){
+      keep_unread(buffer_size);
+    }
+#if defined(COMSTREAM_USE_THREAD)
+    /**
+     * Start background reading.
+     * Reading is performed with a dedicated thread, and its results are queued
+     * in a ring of pages. The consumer takes pages without any lock while they are available,
+     * and otherwise blocks until the reader notifies it.
+     *
+     * @param page_size maximum characters per page
+     * @param num_pages number of pages in the ring
+     */
+    void start_reader(const std::size_t &page_size = 0x1000, const std::size_t &num_pages = 0x10){
+      if(reader){return;}
+      keep_unread(in_buf.size());
+      reader = new reader_t(this, page_size > 0 ? page_size : 1, num_pages > 1 ? num_pages : 2);
+    }
+    /**
+     * Stop background reading. Characters already read are still available.
+     * Pages which have been queued but not consumed are discarded.
+     */
+    void stop_reader(){
+      if(!reader){return;}
+      keep_unread(in_buf.size());
+      delete reader;
+      reader = NULL;
+    }
+    bool is_reader_running() const {
+      return reader != NULL;
+    }
+#endif
     
   protected:
     
@@ -465,11 +702,10 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
       return comstat.cbInQue;
     }
 #else
-    /* TODO: unistd.h̒ᐅI/O̓obt@OȂ̂߁A
-     * streambuf̕Wł0Ԃł悢?
-     * @see http://sato-www.cs.titech.ac.jp/pro3/slides/unix2-4.pdf
-     * @see http://www.cplusplus.com/reference/iostream/streambuf/showmanyc/
-     */
+    streamsize showmanyc(){
+      int queued(0);
+      return (ioctl(handle, FIONREAD, &queued) == -1) ? 0 : queued;
+    }
 #endif
     
     /**
@@ -567,23 +803,21 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
      * value of type streamsize.
      * @return The number of characters gotten
      */
-#ifdef _WIN32
     streamsize xsgetn(_Elem *s, streamsize n){
-      //std::cerr << "xsgetn()" << std::endl;
-      DWORD received;
-      ReadFile(handle, s, (DWORD)n, &received, NULL);
-      return (streamsize)received;
+      streamsize res(0);
+      while(res < n){
+        streamsize avail(super_t::egptr() - super_t::gptr());
+        if(avail <= 0){
+          if(_Traits::eq_int_type(underflow(), _Traits::eof())){break;}
+          continue;
+        }
+        if(avail > (n - res)){avail = n - res;}
+        _Traits::copy(s + res, super_t::gptr(), (std::size_t)avail);
+        super_t::gbump((int)avail);
+        res += avail;
+      }
+      return res;
     }
-#else
-    /* TODO: unistd.h̒ᐅI/O̓obt@OȂ̂߁A
-     * ɂƂreadĂяoƂŁA1ǂ݂ŕԂĂĂ܂
-     * streambuf̕WłsbumpcĂяoőΉ
-     * @see http://www.cplusplus.com/reference/iostream/streambuf/xsgetn/
-     */
-    /*streamsize xsgetn(_Elem *s, streamsize n){
-      return read(handle, (void *)s, n);
-    }*/
-#endif
     
     /**
      * Get character in the case of underflow
@@ -618,8 +852,21 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
      */
     int_type underflow(){
       //std::cerr << "underflow()" << std::endl;
-      if(!in_buf_ready){update_in_buf();}
-      return in_buf;
+      if(super_t::gptr() < super_t::egptr()){
+        return _Traits::to_int_type(*super_t::gptr());
+      }
+#if defined(COMSTREAM_USE_THREAD)
+      if(reader){
+        const typename reader_t::page_t &page(reader->next());
+        if(page.length == 0){return _Traits::eof();}
+        _Elem *head(const_cast<_Elem *>(&page.data[0]));
+        super_t::setg(head, head, head + page.length);
+        return _Traits::to_int_type(*head);
+      }
+#endif
+      streamsize received(read_some(&in_buf[0], (streamsize)in_buf.size()));
+      super_t::setg(&in_buf[0], &in_buf[0], &in_buf[0] + received);
+      return (received > 0) ? _Traits::to_int_type(in_buf[0]) : _Traits::eof();
     }
     
     /**
@@ -655,8 +902,9 @@ class basic_ComportStreambuf : public std::basic_streambuf<_Elem, _Traits> {
      */
     int_type uflow(){
       //std::cerr << "uflow()" << std::endl;
-      update_in_buf();
-      return in_buf;
+      int_type res(underflow());
+      if(!_Traits::eq_int_type(res, _Traits::eof())){super_t::gbump(1);}
+      return res;
     }
 };
 
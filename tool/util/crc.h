@@ -37,6 +37,10 @@
 class CRC16 {
   public:
     static const Uint16 crc16_table[];  
+    /**
+     * Calculate CRC16 (CCITT, without reflection) of a buffer.
+     * Eight bytes are processed at once with sliced tables (slicing-by-8).
+     */
     static Uint16 crc16(const unsigned char *buf, int size, Uint16 crc = 0);
     template<class T>
     static Uint16 crc16_generic(const T t, Uint16 crc){
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2016, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <ios>
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Read-only memory mapped file,
+ * whose content can be accessed directly without stream buffer copies.
+ */
+class MappedFile {
+  protected:
+    const char *head;
+    std::size_t length;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#endif
+
+  private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+  public:
+    /**
+     * Check whether the file can be mapped, i.e., it exists as a regular file.
+     *
+     * @param fname file name
+     */
+    static bool is_mappable(const char *fname){
+#ifdef _WIN32
+      DWORD attr(GetFileAttributesA(fname));
+      return (attr != INVALID_FILE_ATTRIBUTES)
+          && !(attr & (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_DEVICE));
+#else
+      struct stat st;
+      return (stat(fname, &st) == 0) && S_ISREG(st.st_mode);
+#endif
+    }
+
+    /**
+     * Map the whole content of a file.
+     *
+     * @param fname file name
+     * @throws std::ios_base::failure when the file cannot be mapped
+     */
+    MappedFile(const char *fname) : head(NULL), length(0) {
+#ifdef _WIN32
+      file = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL,
+          OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+      if(file == INVALID_HANDLE_VALUE){
+        throw std::ios_base::failure(std::string("Could not open ").append(fname));
+      }
+      mapping = NULL;
+      LARGE_INTEGER size;
+      if(!GetFileSizeEx(file, &size)){
+        CloseHandle(file);
+        throw std::ios_base::failure(std::string("Could not stat ").append(fname));
+      }
+      length = (std::size_t)size.QuadPart;
+      if(length == 0){return;}
+      if(!(mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL))
+          || !(head = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))){
+        if(mapping){CloseHandle(mapping);}
+        CloseHandle(file);
+        throw std::ios_base::failure(std::string("Could not map ").append(fname));
+      }
+#else
+      int fd(open(fname, O_RDONLY));
+      if(fd == -1){
+        throw std::ios_base::failure(std::string("Could not open ").append(fname));
+      }
+      struct stat st;
+      if(fstat(fd, &st) == -1){
+        close(fd);
+        throw std::ios_base::failure(std::string("Could not stat ").append(fname));
+      }
+      length = (std::size_t)st.st_size;
+      if(length > 0){
+        void *res(mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0));
+        if(res == MAP_FAILED){
+          close(fd);
+          throw std::ios_base::failure(std::string("Could not map ").append(fname));
+        }
+        head = (const char *)res;
+#if defined(MADV_SEQUENTIAL)
+        madvise(res, length, MADV_SEQUENTIAL);
+#endif
+      }
+      close(fd); // mapping is still valid after the descriptor is closed.
+#endif
+    }
+
+    ~MappedFile(){
+#ifdef _WIN32
+      if(head){UnmapViewOfFile(head);}
+      if(mapping){CloseHandle(mapping);}
+      CloseHandle(file);
+#else
+      if(head){munmap((void *)head, length);}
+#endif
+    }
+
+    const char *data() const {return head;}
+    std::size_t size() const {return length;}
+
+    /**
+     * Sequential reader which divides the content into fixed size pages.
+     */
+    struct page_reader_t {
+      const char *current, *end;
+      unsigned int page_size;
+      /**
+       * Move to the next page
+       *
+       * @param page head of the next page, which points to the mapped memory.
+       * @return (unsigned int) available bytes of the page, which is smaller than page size
+       * only at the truncated tail, and zero at the end.
+       */
+      unsigned int next(const char *&page){
+        std::size_t rest(end - current);
+        if(rest > page_size){rest = page_size;}
+        page = current;
+        current += rest;
+        return (unsigned int)rest;
+      }
+    };
+    page_reader_t pages(const unsigned int &page_size) const {
+      page_reader_t res = {head, head + length, page_size};
+      return res;
+    }
+};
+
+#endif /* __MAPPED_FILE_H__ */
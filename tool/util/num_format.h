@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2017, M.Naruoka (fenrir)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the naruoka.org nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+ * OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @file
+ * @brief Fast locale-free number formatting for text output
+ *
+ * Numbers are converted to text with integer arithmetic in place of
+ * the printf family, which std::num_put of the standard library relies on.
+ * The results are identical to those of std::ostream in default notation,
+ * i.e., "%.*g" with the stream precision for floating point values.
+ */
+
+#ifndef __NUM_FORMAT_H__
+#define __NUM_FORMAT_H__
+
+#include <cmath>
+#include <cstddef>
+#include <ios>
+#include <locale>
+#include <iterator>
+#include <algorithm>
+
+struct NumFormat {
+  typedef unsigned long long digits_t;
+
+  /**
+   * Exactly representable powers of ten, 1E0 to 1E22
+   */
+  static const double *pow10(){
+    static const double res[] = {
+      1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, 1E10,
+      1E11, 1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18, 1E19, 1E20,
+      1E21, 1E22};
+    return res;
+  }
+  static const int pow10_max = 22;
+
+  /**
+   * Format an unsigned integer in decimal.
+   *
+   * @param buf buffer, which should have 20 characters at least
+   * @return (char *) end of the written characters
+   */
+  template <class UIntT>
+  static char *format_uint(char *buf, UIntT v){
+    char tmp[24], *p(tmp + sizeof(tmp));
+    do{
+      *(--p) = (char)('0' + (v % 10));
+      v /= 10;
+    }while(v);
+    return std::copy(p, tmp + sizeof(tmp), buf);
+  }
+
+  /**
+   * Format a signed integer in decimal.
+   *
+   * @param buf buffer, which should have 21 characters at least
+   * @return (char *) end of the written characters
+   */
+  template <class IntT, class UIntT>
+  static char *format_int(char *buf, const IntT &v){
+    if(v >= 0){return format_uint(buf, (UIntT)v);}
+    *(buf++) = '-';
+    return format_uint(buf, (UIntT)(-(v + 1)) + 1);
+  }
+
+  /**
+   * Format a floating point value in the same manner as "%.*g".
+   * The value is scaled with an exact power of ten so that the integer part has
+   * the requested number of significant digits, and then rounded.
+   * Because the scaling is correctly rounded, the result is same as
+   * the exact decimal conversion except for ties, which are detected.
+   *
+   * @param buf buffer, which should have 24 characters at least
+   * @param v value
+   * @param precision number of significant digits
+   * @return (char *) end of the written characters, or NULL when the fast path
+   * is not applicable, i.e., v is not finite, precision is out of [1, 15],
+   * magnitude is too large or too small, or rounding is too close to a tie.
+   */
+  static char *format_general(char *buf, double v, const int &precision){
+    if((precision < 1) || (precision > 15) || !(v - v == 0)){return NULL;}
+    char *p(buf);
+    if((v < 0) || ((v == 0) && (1. / v < 0))){
+      *(p++) = '-';
+      v = -v;
+    }
+    if(v == 0){
+      *(p++) = '0';
+      return p;
+    }
+
+    const double *p10(pow10());
+    int e((int)std::floor(std::log10(v)));
+    double y;
+    while(true){
+      int k(precision - 1 - e);
+      if((k > pow10_max) || (k < -pow10_max)){return NULL;}
+      y = (k >= 0) ? (v * p10[k]) : (v / p10[-k]);
+      if(y < p10[precision - 1]){ // log10() may be slightly different around powers of ten
+        --e;
+      }else if(y >= p10[precision]){
+        ++e;
+      }else{
+        break;
+      }
+    }
+
+    // y has relative error of 2^-53 at most.
+    double y_int(std::floor(y)), y_frac(y - y_int);
+    if(std::fabs(y_frac - 0.5) <= std::ldexp(y, -52)){return NULL;}
+    digits_t digits((digits_t)y_int + ((y_frac > 0.5) ? 1 : 0));
+    if(digits == (digits_t)p10[precision]){ // carried, for example 9.99...95 => 10.0
+      digits /= 10;
+      ++e;
+    }
+
+    char d[16];
+    for(int i(precision - 1); i >= 0; --i, digits /= 10){
+      d[i] = (char)('0' + (digits % 10));
+    }
+    int len(precision); // trailing zeros are removed
+    while((len > 1) && (d[len - 1] == '0')){--len;}
+
+    if((e < -4) || (e >= precision)){ // scientific notation
+      *(p++) = d[0];
+      if(len > 1){
+        *(p++) = '.';
+        p = std::copy(d + 1, d + len, p);
+      }
+      *(p++) = 'e';
+      if(e < 0){
+        *(p++) = '-';
+        e = -e;
+      }else{
+        *(p++) = '+';
+      }
+      if(e < 10){*(p++) = '0';}
+      return format_uint(p, (unsigned int)e);
+    }else if(e >= 0){ // fixed notation, |v| >= 1
+      p = std::copy(d, d + e + 1, p);
+      if(len > e + 1){
+        *(p++) = '.';
+        p = std::copy(d + e + 1, d + len, p);
+      }
+      return p;
+    }else{ // fixed notation, |v| < 1
+      *(p++) = '0';
+      *(p++) = '.';
+      for(int i(-1); i > e; --i){*(p++) = '0';}
+      return std::copy(d, d + len, p);
+    }
+  }
+};
+
+/**
+ * Numeric output facet using NumFormat.
+ * It takes over decimal integers and default notation floating point values
+ * without width, sign, and base decorations; other cases are delegated to std::num_put.
+ * Usage: FastNumPut<>::imbue(std::cout);
+ */
+template <class CharT = char, class OutputIt = std::ostreambuf_iterator<CharT> >
+class FastNumPut : public std::num_put<CharT, OutputIt> {
+  public:
+    typedef std::num_put<CharT, OutputIt> super_t;
+    typedef CharT char_type;
+    typedef OutputIt iter_type;
+
+    explicit FastNumPut(std::size_t refs = 0) : super_t(refs) {}
+
+    /**
+     * Replace numeric output facet of a stream.
+     * The stream precision and format flags are left unchanged.
+     */
+    static void imbue(std::ios &io){
+      io.imbue(std::locale(io.getloc(), new FastNumPut()));
+    }
+
+  protected:
+    static bool is_plain(const std::ios_base &str){
+      return (str.width() <= 0)
+          && !(str.flags() & (std::ios_base::showpos | std::ios_base::showbase
+            | std::ios_base::showpoint | std::ios_base::uppercase));
+    }
+    static bool is_plain_int(const std::ios_base &str){
+      return is_plain(str)
+          && ((str.flags() & std::ios_base::basefield) == std::ios_base::dec);
+    }
+    static bool is_plain_float(const std::ios_base &str){
+      return is_plain(str)
+          && ((str.flags() & std::ios_base::floatfield) == 0);
+    }
+    static iter_type put(iter_type out, const char *head, const char *tail){
+      return std::copy(head, tail, out);
+    }
+
+    using super_t::do_put;
+
+    iter_type do_put(iter_type out, std::ios_base &str, char_type fill, long v) const {
+      if(!is_plain_int(str)){return super_t::do_put(out, str, fill, v);}
+      char buf[32];
+      return put(out, buf, NumFormat::format_int<long, unsigned long>(buf, v));
+    }
+    iter_type do_put(iter_type out, std::ios_base &str, char_type fill, unsigned long v) const {
+      if(!is_plain_int(str)){return super_t::do_put(out, str, fill, v);}
+      char buf[32];
+      return put(out, buf, NumFormat::format_uint(buf, v));
+    }
+    iter_type do_put(iter_type out, std::ios_base &str, char_type fill, double v) const {
+      char buf[32], *tail;
+      if(!is_plain_float(str)
+          || !(tail = NumFormat::format_general(buf, v, (int)str.precision()))){
+        return super_t::do_put(out, str, fill, v);
+      }
+      return put(out, buf, tail);
+    }
+};
+
+#endif /* __NUM_FORMAT_H__ */